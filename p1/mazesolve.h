@@ -6,20 +6,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>             // for variadic functions in testing
+#include <stdint.h>             // for uint64_t bitsets
+#include <limits.h>             // for INT_MAX
 
 ////////////////////////////////////////////////////////////////////////////////
 // rcqueue_t data
 ////////////////////////////////////////////////////////////////////////////////
-typedef struct rcnode {         // node type for row/col queues
-  int row, col;                 // row/col coordinates for the node
-  struct rcnode *next;          // pointer to next node
+typedef struct {                // slot type for row/col queues
+  int row, col;                 // row/col coordinates for the slot
 } rcnode_t;
 
-typedef struct {                // queue type for row/col coordinates
-  rcnode_t *front, *rear;       // pointers to ends of queue
-  int count;                    // number of nodes in queue
+typedef struct {                // circular buffer queue of row/col coordinates
+  rcnode_t *slots;              // array of capacity slots
+  int capacity;                 // size of slots, always a power of 2
+  int front;                    // index of the front slot
+  int count;                    // number of coordinates in queue
 } rcqueue_t;
 
+#define RCQUEUE_MIN_CAPACITY 16
+
 ////////////////////////////////////////////////////////////////////////////////
 // tile enumerations
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +35,8 @@ typedef enum {                  // allowable directions for neighbors
   WEST,                         // Same as integer 3
   EAST,                         // Same as integer 4
 } direction_t;
+#define DELTA_START 1           // first real direction in dir_delta[]
+#define DELTA_COUNT 5           // one past the last direction in dir_delta[]
 // EXAMPLE USE:
 // direction_t dirs[5] = {NORTH, WEST, WEST, SOUTH, SOUTH};
 // char *str = direction_verbose_strs[WEST];
@@ -41,11 +48,21 @@ typedef enum {                  // types of supported tiles
   ONPATH,                       // part of shortest path from Start to End, '.'
   START,                        // starting tile, display as 'S'
   END,                          // ending tile, display as 'E'
+  COST2,                        // terrain costing 2 to enter, display as '2'
+  COST3,                        // terrain costing 3 to enter, display as '3'
+  COST4,                        // terrain costing 4 to enter, display as '4'
+  COST5,                        // terrain costing 5 to enter, display as '5'
+  COST6,                        // terrain costing 6 to enter, display as '6'
+  COST7,                        // terrain costing 7 to enter, display as '7'
+  COST8,                        // terrain costing 8 to enter, display as '8'
+  COST9,                        // terrain costing 9 to enter, display as '9'
 } tiletype_t;
+#define TILETYPE_COUNT 14       // number of tile types, entries of tiletype_chars[]
+#define TILE_COST_MAX 9         // largest entry of tile_costs[]
 // EXAMPLE USE:
-// tile_t tile;
-// tile.type = OPEN;
+// MAZE_TYPE(maze, row, col) = OPEN;
 // char display = tiletype_chars[WALL];
+// int cost = tile_costs[MAZE_TYPE(maze, row, col)];
 
 typedef enum {                  // type used during BFS to track found iles
   UNKNOWN   = 0,                // UNKNOWN should not be used
@@ -53,27 +70,52 @@ typedef enum {                  // type used during BFS to track found iles
   FOUND                         // tile has been found during BFS and has its path set
 } searchstate_t;
 // EXAMPLE USE:
-// tile_t tile;
-// tile.state = NOTFOUND;
+// searchstate_t state = BITSET_GET(maze->found, idx) ? FOUND : NOTFOUND;
 
 ////////////////////////////////////////////////////////////////////////////////
 // tile and maze data
 ////////////////////////////////////////////////////////////////////////////////
-typedef struct {                // tile data for positions in a 2D maze
-  tiletype_t type;              // One of NOTSET, OPEN, WALL, ONPATH, START, END
-  searchstate_t state;          // One of NOT_FOUND, QUEUED, DONE
+typedef struct {                // path data for a tile rebuilt after BFS
   direction_t *path;            // array of directions from start to this position
   int path_len;                 // length of path array
 } tile_t;
 
 typedef struct {                // maze data tracking shape of maze and state of BFS search
-  tile_t **tiles;               // 2D array of tiles
-  int rows, cols;               // number of rows/cols in the 2D tile array
+  unsigned char *grid;          // row-major tiletype_t per tile with a border of WALL sentinels
+  uint64_t *found;              // bitset of tiles FOUND during BFS, indexed like grid
+  unsigned char *pred;          // 2-bit incoming direction per FOUND tile, allocated by BFS
+  int *dist;                    // optional distance from Start per tile, NULL unless requested
+  tile_t solution;              // Start to End path rebuilt by maze_set_solution()
+  int rows, cols;               // number of rows/cols of tiles in the maze
+  int stride;                   // cols+2, distance between vertically adjacent grid cells
   int start_row, start_col;     // starting position in the maze
   int end_row, end_col;         // ending position in the maze
   rcqueue_t *queue;             // queue of coordinates to search
+  long expanded;                // number of tiles expanded by the last search
+  long path_cost;               // terrain cost of the path found by a weighted search, -1 if none
+  int *component;               // connected component of each tile by grid index, 0 for WALL, NULL if not labelled
+  int component_count;          // number of components labelled in component
+  int log_level;                // logging of this maze's load and searches, LOG_LEVEL by default
 } maze_t;
 
+// Index of a row/col coordinate in the grid; rows/cols of -1 and
+// rows/cols address the border of WALL sentinels.
+#define MAZE_INDEX(maze,row,col) (((row)+1)*(maze)->stride + (col)+1)
+#define MAZE_TYPE(maze,row,col)  ((maze)->grid[MAZE_INDEX(maze,row,col)])
+#define MAZE_CELLS(maze)         (((long) (maze)->rows+2)*(maze)->stride)
+#define MAZE_MAX_CELLS           INT_MAX  // grid indices are ints, so no maze has more cells
+
+#define BITSET_WORDS(n)      (((n)+63)/64)
+#define BITSET_GET(bits,i)   (((bits)[(i)>>6] >> ((i)&63)) & 1)
+#define BITSET_SET(bits,i)   ((bits)[(i)>>6] |= (1ULL << ((i)&63)))
+
+// Predecessor directions packed 4 per byte; NORTH..EAST are stored as 0..3
+#define PRED_BYTES(n)        (((n)+3)/4)
+#define PRED_SHIFT(i)        (((i)&3)*2)
+#define PRED_GET(pred,i)     ((direction_t) ((((pred)[(i)>>2] >> PRED_SHIFT(i)) & 3) + NORTH))
+#define PRED_SET(pred,i,d)   ((pred)[(i)>>2] = ((pred)[(i)>>2] & ~(3 << PRED_SHIFT(i))) \
+                                               | (((d)-NORTH) << PRED_SHIFT(i)))
+
 ////////////////////////////////////////////////////////////////////////////////
 // other defined symbols 
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,22 +139,284 @@ typedef struct {                // maze data tracking shape of maze and state of
 ////////////////////////////////////////////////////////////////////////////////
 
 extern int LOG_LEVEL;
+extern int BFS_INSTRUMENTED;
+extern __thread FILE *LOAD_ERRORS;
+extern direction_t dir_delta[5];
+extern int row_delta[5];
+extern int col_delta[5];
+extern direction_t dir_opposite[5];
+extern char *direction_compact_strs[5];
+extern char *direction_verbose_strs[5];
+extern char tiletype_chars[];
+extern int tile_costs[];
+extern char digit10_chars[];
 rcqueue_t *rcqueue_allocate();
+rcqueue_t *rcqueue_allocate_capacity(int capacity);
 void rcqueue_add_rear(rcqueue_t *queue, int row, int col);
 void rcqueue_free(rcqueue_t *queue);
 int rcqueue_get_front(rcqueue_t *queue, int *rowp, int *colp);
 int rcqueue_remove_front(rcqueue_t *queue);
 void rcqueue_print(rcqueue_t *queue);
 void tile_print_path(tile_t *tile, int format);
+void tile_fprint_path(tile_t *tile, int format, FILE *out);
 void tile_extend_path(tile_t *src, tile_t *dst, direction_t dir);
 maze_t *maze_allocate(int rows, int cols);
 void maze_free(maze_t *maze);
 int maze_tile_blocked(maze_t *maze, int row, int col);
+int maze_pred_distance(maze_t *maze, int idx);
+int maze_tile_path(maze_t *maze, int row, int col, tile_t *tile);
 void maze_print_tiles(maze_t *maze);
 void maze_print_state(maze_t *maze);
+int maze_queue_capacity(maze_t *maze);
+void maze_bfs_track_distance(maze_t *maze);
+void maze_search_reset(maze_t *maze);
 void maze_bfs_init(maze_t *maze);
 int maze_bfs_process_neighbor(maze_t *maze, int cur_row, int cur_col, direction_t dir);
 int maze_bfs_step(maze_t *maze);
+int maze_bfs_search(maze_t *maze, int stop_at_end);
 void maze_bfs_iterate(maze_t *maze);
+int maze_bfs_solve(maze_t *maze);
+int maze_bfs_flood(maze_t *maze);
+tile_t *maze_end_tile(maze_t *maze);
 int maze_set_solution(maze_t *maze);
 maze_t *maze_from_file(char *fname);
+maze_t *maze_read_file(char *fname, int log_level);
+void maze_load_error(char *fmt, ...);
+int maze_read_header(FILE *handle, int *rows, int *cols);
+
+////////////////////////////////////////////////////////////////////////////////
+// search engines
+////////////////////////////////////////////////////////////////////////////////
+
+// Grid index offset of one step in direction `dir`
+#define DIR_OFFSET(maze,dir) (row_delta[dir]*(maze)->stride + col_delta[dir])
+
+typedef struct {                // search engine selectable by name
+  char *name;                   // name given on the command line
+  int (*solve)(maze_t *maze);   // searches Start to End leaving predecessors for maze_set_solution()
+  int (*flood)(maze_t *maze);   // as solve but searching every reachable tile, NULL if it cannot
+} maze_engine_t;
+
+// mazesolve_engines.c
+extern maze_engine_t maze_engines[];
+maze_engine_t *maze_engine_lookup(char *name);
+void maze_print_engines(FILE *out);
+
+// mazesolve_bidir.c
+int maze_bidir_solve(maze_t *maze);
+
+// mazesolve_astar.c
+typedef struct {                // entry in a min-heap of tiles
+  uint64_t key;                 // priority, smallest first
+  int idx;                      // grid index of the tile, breaks ties in key
+} heapnode_t;
+
+typedef struct {                // 4-ary min-heap of tiles stored in an array
+  heapnode_t *nodes;            // heap ordered array of nodes
+  int count;                    // number of nodes in the heap
+  int capacity;                 // allocated size of nodes
+} tileheap_t;
+
+// Heuristic estimate of the distance from a tile to End; must never
+// overestimate and must be consistent for A* to return shortest paths
+typedef int (*heuristic_t)(void *arg, int idx, int row, int col);
+
+tileheap_t *tileheap_allocate(int capacity);
+void tileheap_free(tileheap_t *heap);
+void tileheap_push(tileheap_t *heap, uint64_t key, int idx);
+int tileheap_pop(tileheap_t *heap, heapnode_t *node);
+int maze_astar_search(maze_t *maze, heuristic_t heuristic, void *arg);
+int maze_astar_solve(maze_t *maze);
+
+// mazesolve_jps.c
+int maze_jps_solve(maze_t *maze);
+
+// mazesolve_bits.c
+int maze_bits_solve(maze_t *maze);
+
+// mazesolve_parallel.c
+extern int BFS_THREADS;
+int maze_parallel_search(maze_t *maze, int stop_at_end);
+int maze_parallel_solve(maze_t *maze);
+int maze_parallel_flood(maze_t *maze);
+
+// mazesolve_hybrid.c
+int maze_hybrid_search(maze_t *maze, int stop_at_end);
+int maze_hybrid_solve(maze_t *maze);
+int maze_hybrid_flood(maze_t *maze);
+
+// mazesolve_dial.c
+int maze_dial_search(maze_t *maze, int stop_at_end);
+int maze_dial_solve(maze_t *maze);
+int maze_dial_flood(maze_t *maze);
+
+// mazesolve_multi.c
+typedef struct {                // BFS seeded from every Start tile of a maze
+  rcnode_t *starts;             // row/col of each Start tile in grid order
+  int start_count;              // number of Start tiles
+  rcnode_t *ends;               // row/col of each End tile in grid order
+  int end_count;                // number of End tiles
+  int *label;                   // index in starts of the nearest Start of each FOUND tile, by grid index
+  int *dist;                    // distance from the nearest Start of each FOUND tile, by grid index
+  int best_start, best_end;     // indices of the closest Start/End pair, -1 if no End is reachable
+  int best_dist;                // distance between the closest pair, -1 if none
+} maze_multi_t;
+
+maze_multi_t *maze_multi_search(maze_t *maze, int stop_at_end);
+void maze_multi_free(maze_multi_t *multi);
+void maze_multi_print(maze_t *maze, maze_multi_t *multi, int all, FILE *out);
+int maze_multi_solve(maze_t *maze);
+int maze_multi_flood(maze_t *maze);
+
+// mazesolve_components.c
+int maze_components_build(maze_t *maze);
+int maze_connected(maze_t *maze, int sr, int sc, int er, int ec);
+
+// mazesolve_msbfs.c
+void maze_msbfs_distances(maze_t *maze, int count, rcnode_t *sources, int *dist);
+void maze_msbfs_distances_to(maze_t *maze, int count, rcnode_t *sources, int row, int col, int *dist);
+rcnode_t *maze_sources_from_file(char *fname, int *countp);
+
+// mazesolve_server.c
+typedef struct cacheentry {     // BFS result for one start tile in a maze_cache_t
+  int start;                    // grid index of the start tile searched from
+  unsigned char *pred;          // packed predecessor directions of the flood from start
+  uint64_t *found;              // FOUND bits of the flood from start
+  struct cacheentry *newer;     // next more recently used entry, NULL for the newest
+  struct cacheentry *older;     // next less recently used entry, NULL for the oldest
+} cacheentry_t;
+
+typedef struct {                // LRU cache of BFS results keyed by start tile
+  cacheentry_t **by_start;      // entry for each grid index or NULL if not cached
+  cacheentry_t *newest;         // most recently used entry
+  cacheentry_t *oldest;         // least recently used entry, evicted first
+  long count;                   // number of entries
+  long entry_bytes;             // bytes of BFS results held by one entry
+  long budget;                  // bytes of BFS results to keep at most
+  long queries, hits;           // queries answered and those whose start was cached
+  long evictions;               // entries evicted to stay within budget
+  long total_ns, hit_ns;        // summed latency of all queries and of hits
+  long rejected;                // queries answered from component labels without a search, not in queries
+} maze_cache_t;
+
+maze_cache_t *maze_cache_allocate(maze_t *maze, long budget);
+void maze_cache_free(maze_cache_t *cache);
+void maze_cache_print_stats(maze_cache_t *cache, FILE *out);
+int maze_serve(maze_t *maze, maze_cache_t *cache, FILE *in, FILE *out);
+int maze_serve_socket(maze_t *maze, maze_cache_t *cache, char *path);
+
+// mazesolve_alt.c
+#define ALT_UNREACHED UINT32_MAX  // landmark distance of tiles the landmark cannot reach
+
+typedef struct {                // landmark distance tables for ALT queries
+  void *base;                   // file image: header, landmarks, then distances
+  long bytes;                   // size of the file image
+  int mapped;                   // 1 if base is mmap()ed from a file, 0 if malloc()ed
+  int count;                    // number of landmarks
+  int width;                    // bytes per distance, 2 or 4
+  int32_t *landmarks;           // grid index of each landmark, inside base
+  uint16_t *dist16;             // tile-major distances when width is 2, inside base
+  uint32_t *dist32;             // tile-major distances when width is 4, inside base
+  uint32_t *target_dist;        // landmark distances of the current query's End
+} alt_t;
+
+extern alt_t *ALT_LANDMARKS;
+extern int ALT_COUNT;
+alt_t *maze_alt_build(maze_t *maze, int count);
+int maze_alt_save(alt_t *alt, char *fname);
+alt_t *maze_alt_load(maze_t *maze, char *fname);
+void maze_alt_free(alt_t *alt);
+int maze_alt_search(maze_t *maze, alt_t *alt);
+int maze_alt_solve(maze_t *maze);
+
+// mazesolve_repair.c
+typedef struct {                // change of one tile between WALL and OPEN
+  int row, col;                 // tile to change
+  tiletype_t type;              // WALL or OPEN, the type of the tile after the edit
+} tileedit_t;
+
+typedef struct {                // batches of tile edits read from an edit file
+  tileedit_t *edits;            // all edits in file order
+  int count;                    // number of edits
+  int *batch_end;               // index one past the last edit of each batch
+  int batches;                  // number of batches
+} editlist_t;
+
+typedef struct {                // scratch state for repairing the flood of one maze
+  uint64_t *affected;           // bitset of tiles whose distance is being recomputed
+  uint64_t *seeded;             // bitset of tiles already added as seeds
+  heapnode_t *seeds;            // tiles a repair phase starts from, sorted by distance
+  long seed_count, seed_pos;    // number of seeds and the next one to dequeue
+  heapnode_t *fifo;             // tiles reached during a phase in nondecreasing distance
+  long head, tail;              // next tile to dequeue from fifo and one past the last
+  int *touched;                 // affected tiles, to clear their bits after the repair
+  long affected_count;          // number of affected tiles in the last repair
+} maze_repair_t;
+
+maze_repair_t *maze_repair_allocate(maze_t *maze);
+void maze_repair_free(maze_repair_t *rep);
+int maze_repair_apply(maze_t *maze, maze_repair_t *rep, tileedit_t *edits, int count);
+editlist_t *maze_edits_from_file(char *fname);
+void maze_edits_free(editlist_t *list);
+int maze_repair_benchmark(maze_t *maze, editlist_t *list, FILE *out);
+
+// mazesolve_extern.c
+int maze_extern_solve(char *fname, char *dir, long budget, int stats, FILE *out);
+
+// mazesolve_render.c
+typedef struct {                // window of tiles drawn by the printers
+  int row, col;                 // top left tile of the window
+  int rows, cols;               // size of the window, -1 to the edge of the maze
+} maze_view_t;
+
+extern maze_view_t PRINT_VIEW;
+void maze_render_tiles(maze_t *maze, maze_view_t *view, FILE *out);
+void maze_render_state(maze_t *maze, maze_view_t *view, FILE *out);
+
+// mazesolve_batch.c
+char **maze_batch_files(char *path, int *count);
+void maze_batch_files_free(char **files, int count);
+int maze_batch_solve(char **files, int count, maze_engine_t *engine, int workers, char *outdir, FILE *out);
+
+// mazesolve_binary.c
+#define MAZEBIN_MAGIC "MAZEBIN1"
+
+typedef struct {                // header at the start of a binary maze file
+  char magic[8];                // MAZEBIN_MAGIC
+  int32_t rows, cols;           // size of the maze
+  int32_t start_row, start_col; // Start tile, row -1 if none
+  int32_t end_row, end_col;     // End tile, row -1 if none
+  int32_t words;                // 64-bit words per row, (cols+63)/64
+  int32_t reserved;             // zero, keeps the rows 8-byte aligned
+} mazebinheader_t;
+
+typedef struct {                // binary maze file mapped into memory
+  mazebinheader_t *header;      // start of the mapping
+  uint64_t *walls;              // rows*words words of WALL bits, inside the mapping
+  long bytes;                   // size of the mapping
+} mazebin_t;
+
+// Wall bits of row `row` of a mapped binary maze, header->words words
+#define MAZEBIN_ROW(bin,row) (&(bin)->walls[(long) (row) * (bin)->header->words])
+
+mazebin_t *maze_binary_open(char *fname);
+void maze_binary_close(mazebin_t *bin);
+int maze_binary_detect(char *fname);
+maze_t *maze_from_binary(mazebin_t *bin, int log_level);
+int maze_save_binary(maze_t *maze, char *fname);
+int maze_save_text(maze_t *maze, char *fname);
+
+// mazesolve_load.c
+extern int LOAD_MAPPED;
+extern int LOAD_THREADS;
+maze_t *maze_load_mapped(char *fname, int log_level);
+
+// mazesolve_gen.c
+typedef struct {                // maze generator selectable by name
+  char *name;                   // name given on the command line
+  void (*generate)(FILE *out, int rows, int cols, uint64_t *rng, double density); // writes the tile rows
+} maze_style_t;
+
+extern maze_style_t maze_styles[];
+maze_style_t *maze_style_lookup(char *name);
+void maze_generate(FILE *out, maze_style_t *style, int rows, int cols, uint64_t seed, double density);
@@ -0,0 +1,390 @@
+// mazesolve_alt.c: A* with landmark distance tables (ALT) for repeated queries
+#include "mazesolve.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+alt_t *ALT_LANDMARKS = NULL;    // landmarks used by the alt engine, built on first use if NULL
+int ALT_COUNT = 16;             // landmarks picked when the alt engine builds its own
+
+// ALT ("A*, landmarks, triangle inequality") precomputes the BFS
+// distance from a few landmark tiles L to every tile. For any tiles v
+// and t the triangle inequality gives
+//
+//   dist(v,t) >= |d(L,t) - d(L,v)|
+//
+// so the largest such bound over all landmarks is an admissible and
+// consistent A* heuristic. It is far tighter than the Manhattan
+// distance in a maze because it follows the corridors, so A* expands
+// little more than the shortest path itself.
+//
+// Tables hold one uint16_t (or uint32_t for mazes with longer paths)
+// per tile and landmark, laid out tile-major so the distances of one
+// tile to all landmarks share a cache line. A table file is the
+// altheader_t, the landmark grid indices padded to 8 bytes, then the
+// distances, so it can be mmap()ed and used in place.
+
+#define ALT_MAGIC "MAZEALT1"
+
+typedef struct {                // header at the start of a landmark file
+  char magic[8];                // ALT_MAGIC
+  int32_t rows, cols;           // size of the maze the tables were built for
+  int32_t count;                // number of landmarks
+  int32_t width;                // bytes per distance, 2 or 4
+  uint64_t grid_hash;           // alt_grid_hash() of the maze the tables were built for
+} altheader_t;
+
+// Distance from landmark `l` to grid index `idx`, ALT_UNREACHED if none
+#define ALT_DIST(alt,idx,l) ((alt)->width == 2 ? \
+  ((alt)->dist16[(long) (idx)*(alt)->count + (l)] == UINT16_MAX ? ALT_UNREACHED : \
+   (alt)->dist16[(long) (idx)*(alt)->count + (l)]) : \
+  (alt)->dist32[(long) (idx)*(alt)->count + (l)])
+
+// FNV-1a hash of which tiles of `maze` are walls, so tables built for
+// one maze are not used with another of the same size
+static uint64_t alt_grid_hash(maze_t *maze) {
+  uint64_t hash = 14695981039346656037ULL;
+  long cells = MAZE_CELLS(maze);
+  for (long i = 0; i < cells; i++) {
+    hash = (hash ^ (maze->grid[i] == WALL)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Bytes before the distances in a landmark file
+static long alt_header_bytes(int count) {
+  return (sizeof(altheader_t) + sizeof(int32_t) * count + 7) / 8 * 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Preprocessing
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {                // work shared by the landmark BFS threads
+  maze_t *maze;                 // maze being preprocessed
+  int *landmarks;               // grid index of each landmark
+  int count;                    // number of landmarks
+  uint32_t *tables;             // tile-major distances, count per tile
+  uint32_t longest;             // longest reachable distance from any landmark, raised atomically
+  int next;                     // next landmark to search, taken atomically
+} altwork_t;
+
+// Fills `dist`, indexed like the grid and ALT_UNREACHED wherever
+// unset, with BFS distances from grid index `source`. `queue` must
+// hold MAZE_CELLS(maze) ints. Uses only the grid so it is safe to run
+// on several threads. Returns the longest distance found.
+static uint32_t alt_bfs(maze_t *maze, int source, uint32_t *dist, int *queue) {
+  long head = 0, tail = 0;
+  queue[tail++] = source;
+  dist[source] = 0;
+  while (head < tail) {
+    int cur = queue[head++];
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      int n = cur + DIR_OFFSET(maze, dir_delta[i]);
+      if (maze->grid[n] != WALL && dist[n] == ALT_UNREACHED) {
+        dist[n] = dist[cur] + 1;
+        queue[tail++] = n;
+      }
+    }
+  }
+  return dist[queue[tail - 1]];  // BFS finds tiles in order of distance
+}
+
+// Searches from landmarks taken from `work` until none are left. Each
+// search runs in the worker's own grid-indexed array, which is then
+// copied into its landmark's column of the tile-major tables.
+static void *alt_worker(void *arg) {
+  altwork_t *work = arg;
+  long cells = MAZE_CELLS(work->maze);
+  int count = work->count;
+  int *queue = malloc(sizeof(int) * cells);
+  uint32_t *dist = malloc(sizeof(uint32_t) * cells);
+  int l;
+  while ((l = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED)) < count) {
+    memset(dist, 0xFF, sizeof(uint32_t) * cells);  // every distance ALT_UNREACHED
+    uint32_t longest = alt_bfs(work->maze, work->landmarks[l], dist, queue);
+    for (long idx = 0; idx < cells; idx++) {
+      work->tables[idx * count + l] = dist[idx];
+    }
+    uint32_t seen = __atomic_load_n(&work->longest, __ATOMIC_RELAXED);
+    while (longest > seen &&
+           !__atomic_compare_exchange_n(&work->longest, &seen, longest, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+  }
+  free(dist);
+  free(queue);
+  return NULL;
+}
+
+// Returns the grid index of the tile nearest by Manhattan distance to
+// (pr,pc) that is open and, if `reach` is given, reachable, preferring
+// smaller rows then cols among equally near ones; -1 if there is none.
+// Searches rings of growing distance around (pr,pc) so only tiles
+// nearer than the answer are looked at.
+static int alt_nearest_open(maze_t *maze, uint32_t *reach, int pr, int pc) {
+  int rows = maze->rows, cols = maze->cols;
+  int far = (pr > rows - 1 - pr ? pr : rows - 1 - pr) + (pc > cols - 1 - pc ? pc : cols - 1 - pc);
+  for (int d = 0; d <= far; d++) {
+    int r0 = pr - d < 0 ? 0 : pr - d, r1 = pr + d > rows - 1 ? rows - 1 : pr + d;
+    for (int r = r0; r <= r1; r++) {
+      int dc = d - abs(r - pr);
+      for (int c = pc - dc; c <= pc + dc; c += dc > 0 ? 2 * dc : 1) {
+        if (c < 0 || c >= cols) {
+          continue;
+        }
+        int idx = MAZE_INDEX(maze, r, c);
+        if (maze->grid[idx] != WALL && (reach == NULL || reach[idx] != ALT_UNREACHED)) {
+          return idx;
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+// Picks `count` landmarks spread evenly around the border of the maze:
+// for each of `count` points along the border, the open tile nearest
+// to it. Tiles on the border of a maze make good landmarks as shortest
+// paths between inner tiles tend to point towards or away from them.
+// Only tiles reachable from Start are used when the maze has a Start.
+// Returns the number of distinct landmarks put in `landmarks`.
+static int alt_pick_landmarks(maze_t *maze, int count, int *landmarks) {
+  uint32_t *reach = NULL;  // distance from Start, ALT_UNREACHED if unreachable
+  if (maze->start_row >= 0) {
+    long cells = MAZE_CELLS(maze);
+    reach = malloc(sizeof(uint32_t) * cells);
+    memset(reach, 0xFF, sizeof(uint32_t) * cells);
+    int *queue = malloc(sizeof(int) * cells);
+    alt_bfs(maze, MAZE_INDEX(maze, maze->start_row, maze->start_col), reach, queue);
+    free(queue);
+  }
+
+  int rows = maze->rows, cols = maze->cols;
+  long perimeter = rows == 1 || cols == 1 ? (long) rows * cols : 2L * (rows + cols) - 4;
+  int picked = 0;
+  for (int i = 0; i < count; i++) {
+    // Walk the border clockwise from the top left corner to point p
+    long p = perimeter * i / count;
+    int pr, pc;
+    if (p < cols) {                          // top row, left to right
+      pr = 0, pc = p;
+    } else if (p < cols + rows - 1) {        // right column, downwards
+      pr = p - cols + 1, pc = cols - 1;
+    } else if (p < 2L * cols + rows - 2) {   // bottom row, right to left
+      pr = rows - 1, pc = cols - 2 - (p - cols - rows + 1);
+    } else {                                 // left column, upwards
+      pr = rows - 2 - (p - 2 * cols - rows + 2), pc = 0;
+    }
+
+    int best = alt_nearest_open(maze, reach, pr, pc);
+    int seen = 0;
+    for (int j = 0; j < picked; j++) {
+      seen |= landmarks[j] == best;
+    }
+    if (best >= 0 && !seen) {
+      landmarks[picked++] = best;
+    }
+  }
+  free(reach);
+  return picked;
+}
+
+// Builds landmark tables for `maze` with up to `count` landmarks,
+// running the landmark searches on BFS_THREADS threads. Distances are
+// stored as uint16_t when every one fits and uint32_t otherwise.
+// Returns NULL if the maze has no open tiles.
+alt_t *maze_alt_build(maze_t *maze, int count) {
+  int *landmarks = malloc(sizeof(int) * count);
+  count = alt_pick_landmarks(maze, count, landmarks);
+  if (count == 0) {
+    free(landmarks);
+    return NULL;
+  }
+
+  // The searches write straight into uint32_t tables laid out
+  // tile-major as they are stored in a file, so only one full copy of
+  // the distances is ever held
+  long cells = MAZE_CELLS(maze);
+  long header = alt_header_bytes(count);
+  alt_t *alt = calloc(1, sizeof(alt_t));
+  alt->bytes = header + sizeof(uint32_t) * cells * count;
+  alt->base = malloc(alt->bytes);
+  altwork_t work = {.maze = maze, .landmarks = landmarks, .count = count,
+                    .tables = (uint32_t *) ((char *) alt->base + header), .longest = 0, .next = 0};
+
+  int threads = BFS_THREADS > 0 ? BFS_THREADS : (int) sysconf(_SC_NPROCESSORS_ONLN);
+  threads = threads < 1 ? 1 : threads > count ? count : threads;
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  for (int t = 1; t < threads; t++) {
+    pthread_create(&tids[t], NULL, alt_worker, &work);
+  }
+  alt_worker(&work);
+  for (int t = 1; t < threads; t++) {
+    pthread_join(tids[t], NULL);
+  }
+  free(tids);
+
+  // Narrow the tables to uint16_t in place if all reachable distances
+  // fit below its sentinel; entry i moves from byte 4i to byte 2i, so
+  // a forward pass never overwrites an entry before reading it
+  int width = work.longest < UINT16_MAX ? 2 : 4;
+  if (width == 2) {
+    uint16_t *narrow = (uint16_t *) work.tables;
+    for (long i = 0; i < cells * count; i++) {
+      uint32_t d = work.tables[i];
+      narrow[i] = d == ALT_UNREACHED ? UINT16_MAX : d;
+    }
+    alt->bytes = header + sizeof(uint16_t) * cells * count;
+    alt->base = realloc(alt->base, alt->bytes);
+  }
+
+  altheader_t *head = alt->base;
+  memset(head, 0, header);
+  memcpy(head->magic, ALT_MAGIC, sizeof(head->magic));
+  head->rows = maze->rows;
+  head->cols = maze->cols;
+  head->count = count;
+  head->width = width;
+  head->grid_hash = alt_grid_hash(maze);
+  int32_t *marks = (int32_t *) (head + 1);
+  for (int l = 0; l < count; l++) {
+    marks[l] = landmarks[l];
+  }
+  free(landmarks);
+
+  void *tables = (char *) alt->base + header;
+  alt->count = count;
+  alt->width = width;
+  alt->landmarks = marks;
+  alt->dist16 = tables;
+  alt->dist32 = tables;
+  alt->target_dist = malloc(sizeof(uint32_t) * count);
+  return alt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Landmark files
+////////////////////////////////////////////////////////////////////////////////
+
+// Writes the landmark tables to `fname`. Returns 0 on success and 1
+// after printing an error if the file cannot be written.
+int maze_alt_save(alt_t *alt, char *fname) {
+  FILE *fout = fopen(fname, "wb");
+  if (fout == NULL || fwrite(alt->base, 1, alt->bytes, fout) != (size_t) alt->bytes) {
+    printf("ERROR: could not write landmark file %s\n", fname);
+    if (fout != NULL) {
+      fclose(fout);
+    }
+    return 1;
+  }
+  fclose(fout);
+  return 0;
+}
+
+// Maps the landmark file `fname` built for `maze` into memory; the
+// tables are used in place and paged in on demand. Returns NULL after
+// printing an error if the file cannot be read or does not match the
+// size of `maze`.
+alt_t *maze_alt_load(maze_t *maze, char *fname) {
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    printf("ERROR: could not open landmark file %s\n", fname);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return NULL;
+  }
+  void *base = st.st_size >= (off_t) sizeof(altheader_t) ?
+    mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED) {
+    printf("ERROR: could not map landmark file %s\n", fname);
+    return NULL;
+  }
+
+  altheader_t *head = base;
+  long cells = MAZE_CELLS(maze);
+  if (memcmp(head->magic, ALT_MAGIC, sizeof(head->magic)) != 0 ||
+      head->rows != maze->rows || head->cols != maze->cols ||
+      (head->width != 2 && head->width != 4) || head->count <= 0 ||
+      head->grid_hash != alt_grid_hash(maze) ||
+      st.st_size != alt_header_bytes(head->count) + (long) head->width * cells * head->count) {
+    printf("ERROR: landmark file %s does not match the maze\n", fname);
+    munmap(base, st.st_size);
+    return NULL;
+  }
+
+  alt_t *alt = calloc(1, sizeof(alt_t));
+  alt->base = base;
+  alt->bytes = st.st_size;
+  alt->mapped = 1;
+  alt->count = head->count;
+  alt->width = head->width;
+  alt->landmarks = (int32_t *) (head + 1);
+  alt->dist16 = (uint16_t *) ((char *) base + alt_header_bytes(head->count));
+  alt->dist32 = (uint32_t *) alt->dist16;
+  alt->target_dist = malloc(sizeof(uint32_t) * alt->count);
+  return alt;
+}
+
+// Frees or unmaps the landmark tables.
+void maze_alt_free(alt_t *alt) {
+  if (alt->mapped) {
+    munmap(alt->base, alt->bytes);
+  } else {
+    free(alt->base);
+  }
+  free(alt->target_dist);
+  free(alt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queries
+////////////////////////////////////////////////////////////////////////////////
+
+// Largest landmark lower bound on the distance from `idx` to the
+// target whose landmark distances are in alt->target_dist.
+static int alt_heuristic(void *arg, int idx, int row, int col) {
+  alt_t *alt = arg;
+  uint32_t best = 0;
+  for (int l = 0; l < alt->count; l++) {
+    uint32_t to_target = alt->target_dist[l];
+    uint32_t to_tile = ALT_DIST(alt, idx, l);
+    if (to_target == ALT_UNREACHED || to_tile == ALT_UNREACHED) {
+      continue;  // landmark in another part of the maze bounds nothing
+    }
+    uint32_t bound = to_target > to_tile ? to_target - to_tile : to_tile - to_target;
+    best = bound > best ? bound : best;
+  }
+  return best;
+}
+
+// A* from Start to End guided by the landmark tables `alt`. Returns 1
+// if End is reachable, leaving predecessors for maze_set_solution() as
+// maze_astar_search() does.
+int maze_alt_search(maze_t *maze, alt_t *alt) {
+  if (maze->end_row < 0) {
+    maze->expanded = 0;
+    return 0;
+  }
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  for (int l = 0; l < alt->count; l++) {
+    alt->target_dist[l] = ALT_DIST(alt, end, l);
+  }
+  return maze_astar_search(maze, alt_heuristic, alt);
+}
+
+// ALT engine: A* using ALT_LANDMARKS, building ALT_COUNT landmarks for
+// the maze first if none were loaded.
+int maze_alt_solve(maze_t *maze) {
+  if (ALT_LANDMARKS == NULL) {
+    ALT_LANDMARKS = maze_alt_build(maze, ALT_COUNT);
+    if (ALT_LANDMARKS == NULL) {
+      return maze_astar_solve(maze);  // no open tiles to put landmarks on
+    }
+  }
+  return maze_alt_search(maze, ALT_LANDMARKS);
+}
@@ -0,0 +1,180 @@
+// mazesolve_astar.c: A* search guided by a distance heuristic
+#include "mazesolve.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 4-ary min-heap of tiles
+////////////////////////////////////////////////////////////////////////////////
+
+// A 4-ary heap is half as deep as a binary heap and the four children
+// of a node sit next to each other in memory, so sifting down touches
+// fewer cache lines per level.
+#define HEAP_ARITY 4
+
+// Ordering of heap nodes: smaller key first, ties broken by smaller
+// grid index so the search order never depends on insertion order.
+#define HEAP_LESS(a,b) ((a).key < (b).key || ((a).key == (b).key && (a).idx < (b).idx))
+
+// Allocates an empty heap with room for `capacity` nodes before growing.
+tileheap_t *tileheap_allocate(int capacity) {
+  tileheap_t *heap = malloc(sizeof(tileheap_t));
+  heap->capacity = capacity > 16 ? capacity : 16;
+  heap->nodes = malloc(sizeof(heapnode_t) * heap->capacity);
+  heap->count = 0;
+  return heap;
+}
+
+// Frees the heap and its nodes.
+void tileheap_free(tileheap_t *heap) {
+  free(heap->nodes);
+  free(heap);
+}
+
+// Adds a tile with the given priority key, doubling the node array when full.
+void tileheap_push(tileheap_t *heap, uint64_t key, int idx) {
+  if (heap->count == heap->capacity) {
+    heap->capacity *= 2;
+    heap->nodes = realloc(heap->nodes, sizeof(heapnode_t) * heap->capacity);
+  }
+
+  // Sift the hole up from the end until the parent is no larger
+  heapnode_t node = {.key = key, .idx = idx};
+  int i = heap->count++;
+  while (i > 0) {
+    int parent = (i - 1) / HEAP_ARITY;
+    if (!HEAP_LESS(node, heap->nodes[parent])) {
+      break;
+    }
+    heap->nodes[i] = heap->nodes[parent];
+    i = parent;
+  }
+  heap->nodes[i] = node;
+}
+
+// Removes the smallest node into `node`. Returns 1 on success and 0 if
+// the heap is empty.
+int tileheap_pop(tileheap_t *heap, heapnode_t *node) {
+  if (heap->count == 0) {
+    return 0;
+  }
+  *node = heap->nodes[0];
+  heapnode_t last = heap->nodes[--heap->count];
+
+  // Sift the hole down from the root, moving up the smallest child
+  int i = 0;
+  while (1) {
+    int first = i * HEAP_ARITY + 1;
+    if (first >= heap->count) {
+      break;
+    }
+    int stop = first + HEAP_ARITY < heap->count ? first + HEAP_ARITY : heap->count;
+    int min = first;
+    for (int c = first + 1; c < stop; c++) {
+      if (HEAP_LESS(heap->nodes[c], heap->nodes[min])) {
+        min = c;
+      }
+    }
+    if (!HEAP_LESS(heap->nodes[min], last)) {
+      break;
+    }
+    heap->nodes[i] = heap->nodes[min];
+    i = min;
+  }
+  heap->nodes[i] = last;
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A* search
+////////////////////////////////////////////////////////////////////////////////
+
+// Heap key for a tile with estimated total f = g + h. Equal f values
+// prefer the smaller h, i.e. the tile that has travelled further and
+// is closer to End, which keeps A* from widening across plateaus.
+#define ASTAR_KEY(f,h) ((((uint64_t) (f)) << 32) | (uint32_t) (h))
+
+// Manhattan distance to the End tile; exact in an open 4-connected grid
+// so it never overestimates.
+static int manhattan_heuristic(void *arg, int idx, int row, int col) {
+  maze_t *maze = arg;
+  return abs(row - maze->end_row) + abs(col - maze->end_col);
+}
+
+// Searches from Start to End with A*, expanding tiles in order of the
+// distance so far plus `heuristic` estimate of the remaining
+// distance. Newly reached or improved tiles get their predecessor
+// direction recorded and are pushed on the heap; stale heap entries
+// for already expanded tiles are skipped when popped. With a
+// consistent heuristic every expanded tile has its final distance so
+// the search stops as soon as End is expanded and the predecessors
+// give a shortest path. Returns 1 if End is reachable and leaves the
+// number of expanded tiles in maze->expanded.
+int maze_astar_search(maze_t *maze, heuristic_t heuristic, void *arg) {
+  maze->expanded = 0;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return 0;  // need both Start and End to search between them
+  }
+  maze_search_reset(maze);
+
+  // Distance from Start of FOUND tiles; shared with maze->dist if it is tracked
+  long cells = MAZE_CELLS(maze);
+  int *g = maze->dist != NULL ? maze->dist : malloc(sizeof(int) * cells);
+  uint64_t *closed = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  tileheap_t *open = tileheap_allocate(maze_queue_capacity(maze));
+
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  int h = heuristic(arg, start, maze->start_row, maze->start_col);
+  g[start] = 0;
+  tileheap_push(open, ASTAR_KEY(h, h), start);
+
+  int solved = 0;
+  heapnode_t node;
+  while (tileheap_pop(open, &node)) {
+    int cur = node.idx;
+    if (BITSET_GET(closed, cur)) {
+      continue;  // stale entry for a tile expanded with a shorter distance
+    }
+    BITSET_SET(closed, cur);
+    maze->expanded++;
+    if (cur == end) {
+      solved = 1;
+      break;
+    }
+
+    int row = cur / maze->stride - 1;
+    int col = cur % maze->stride - 1;
+    if (maze->log_level >= LOG_BFS_STEPS) {
+      printf("LOG: processing neighbors of (%d,%d)\n", row, col);
+    }
+
+    // Relax each open neighbor that is not yet expanded
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      int next = cur + DIR_OFFSET(maze, dir);
+      if (maze->grid[next] == WALL || BITSET_GET(closed, next)) {
+        continue;
+      }
+      int next_g = g[cur] + 1;
+      if (BITSET_GET(maze->found, next) && g[next] <= next_g) {
+        continue;  // already reached at least as cheaply
+      }
+      BITSET_SET(maze->found, next);
+      PRED_SET(maze->pred, next, dir);
+      g[next] = next_g;
+      h = heuristic(arg, next, row + row_delta[dir], col + col_delta[dir]);
+      tileheap_push(open, ASTAR_KEY(next_g + h, h), next);
+    }
+  }
+
+  if (g != maze->dist) {
+    free(g);
+  }
+  free(closed);
+  tileheap_free(open);
+  return solved;
+}
+
+// A* from Start to End using the Manhattan distance to End.
+int maze_astar_solve(maze_t *maze) {
+  return maze_astar_search(maze, manhattan_heuristic, maze);
+}
@@ -0,0 +1,230 @@
+// mazesolve_batch.c: solves many maze files on a fixed pool of worker threads
+#include "mazesolve.h"
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>             // for sysconf()
+#include <dirent.h>
+#include <sys/stat.h>
+
+// A batch is a list of maze files, either every regular file in a
+// directory in name order or the lines of a list file. Workers take
+// the next file from a shared counter and load, solve and print it on
+// their own: mazes are read with maze_read_file() at log level 0 so no
+// worker touches LOG_LEVEL or writes to stdout behind the others; their
+// errors go to the maze's own output through LOAD_ERRORS.
+//
+// Each maze prints what mazesolve_main prints after solving. With an
+// output directory it goes to DIR/<file name>.sol. Otherwise every
+// maze is formatted into memory, headed by "==> FILE <==", and the
+// texts are written to one stream in batch order as they complete, so
+// the stream does not depend on the number of workers. The alt engine
+// keeps one global set of landmarks, ALT_LANDMARKS, so it cannot be
+// shared by mazes solved at the same time and is refused.
+
+typedef struct {                // state shared by the workers of a batch
+  char **files;                 // maze files to solve
+  int count;                    // number of files
+  int next;                     // index of the next file to take, advanced atomically
+  maze_engine_t *engine;        // engine solving each maze
+  char *outdir;                 // directory of per-maze outputs, NULL for one stream
+  FILE *out;                    // stream of all outputs when outdir is NULL
+  char **texts;                 // formatted outputs waiting for earlier ones, NULL if not done
+  size_t *lengths;              // length of each formatted output
+  int written;                  // number of outputs written to out
+  pthread_mutex_t lock;         // guards texts, lengths and written
+} batch_t;
+
+typedef struct {                // one worker thread and what it solved
+  batch_t *batch;               // shared state
+  pthread_t tid;                // thread running the worker
+  int solved, unsolved, failed; // mazes with a path, without one and that did not load
+} batchworker_t;
+
+static int batch_compare_names(const void *a, const void *b) {
+  return strcmp(*(char **) a, *(char **) b);
+}
+
+// Appends a copy of `name` to the array `*files`, doubling it when full.
+static void batch_add_file(char ***files, int *count, int *capacity, char *name) {
+  if (*count == *capacity) {
+    *capacity *= 2;
+    *files = realloc(*files, sizeof(char *) * *capacity);
+  }
+  (*files)[(*count)++] = strdup(name);
+}
+
+// Returns the maze files named by `path` and sets `*count`. A
+// directory gives each regular file in it not starting with '.',
+// sorted by name; any other file lists one maze file per line, with
+// blank lines and those starting with '#' ignored. Returns NULL after
+// printing an error if `path` cannot be read.
+char **maze_batch_files(char *path, int *count) {
+  int capacity = 64;
+  char **files = malloc(sizeof(char *) * capacity);
+  *count = 0;
+  char name[4096];
+
+  DIR *dir = opendir(path);
+  if (dir != NULL) {
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      struct stat st;
+      snprintf(name, sizeof(name), "%s/%s", path, entry->d_name);
+      if (entry->d_name[0] != '.' && stat(name, &st) == 0 && S_ISREG(st.st_mode)) {
+        batch_add_file(&files, count, &capacity, name);
+      }
+    }
+    closedir(dir);
+    qsort(files, *count, sizeof(char *), batch_compare_names);
+    return files;
+  }
+
+  FILE *list = fopen(path, "r");
+  if (list == NULL) {
+    printf("ERROR: could not open batch %s\n", path);
+    free(files);
+    return NULL;
+  }
+  while (fgets(name, sizeof(name), list) != NULL) {
+    name[strcspn(name, "\r\n")] = '\0';
+    if (name[0] != '\0' && name[0] != '#') {
+      batch_add_file(&files, count, &capacity, name);
+    }
+  }
+  fclose(list);
+  return files;
+}
+
+// Frees the file list of maze_batch_files().
+void maze_batch_files_free(char **files, int count) {
+  for (int i = 0; i < count; i++) {
+    free(files[i]);
+  }
+  free(files);
+}
+
+// Loads, solves and prints the maze in `fname` to `out`, counting the
+// result in `worker`.
+static void batch_solve_one(batchworker_t *worker, char *fname, FILE *out) {
+  LOAD_ERRORS = out;
+  maze_t *maze = maze_read_file(fname, 0);
+  LOAD_ERRORS = NULL;
+  if (maze == NULL) {
+    fprintf(out, "ERROR: could not load maze\n");
+    worker->failed++;
+    return;
+  }
+  worker->batch->engine->solve(maze);
+  maze_set_solution(maze);
+  tile_t *end = maze_end_tile(maze);
+  if (end->path == NULL) {
+    fprintf(out, "No solution found.\n");
+    worker->unsolved++;
+  } else {
+    fprintf(out, "SOLUTION:\n");
+    maze_render_tiles(maze, &PRINT_VIEW, out);
+    tile_fprint_path(end, PATH_FORMAT_VERBOSE, out);
+    worker->solved++;
+  }
+  maze_free(maze);
+}
+
+// Stores the output of maze `i` and writes every output that is now
+// next in batch order to the shared stream.
+static void batch_emit(batch_t *batch, int i, char *text, size_t length) {
+  pthread_mutex_lock(&batch->lock);
+  batch->texts[i] = text;
+  batch->lengths[i] = length;
+  while (batch->written < batch->count && batch->texts[batch->written] != NULL) {
+    fwrite(batch->texts[batch->written], 1, batch->lengths[batch->written], batch->out);
+    free(batch->texts[batch->written]);
+    batch->texts[batch->written] = NULL;
+    batch->written++;
+  }
+  pthread_mutex_unlock(&batch->lock);
+}
+
+// Solves mazes taken from the batch until none are left.
+static void *batch_worker(void *arg) {
+  batchworker_t *worker = arg;
+  batch_t *batch = worker->batch;
+  int i;
+  while ((i = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED)) < batch->count) {
+    char *fname = batch->files[i];
+    if (batch->outdir != NULL) {
+      char *base = strrchr(fname, '/');
+      char oname[4096];
+      snprintf(oname, sizeof(oname), "%s/%s.sol", batch->outdir, base != NULL ? base + 1 : fname);
+      FILE *out = fopen(oname, "w");
+      if (out == NULL) {
+        printf("ERROR: could not write %s\n", oname);
+        worker->failed++;
+        continue;
+      }
+      batch_solve_one(worker, fname, out);
+      fclose(out);
+    } else {
+      char *text;
+      size_t length;
+      FILE *out = open_memstream(&text, &length);
+      fprintf(out, "==> %s <==\n", fname);
+      batch_solve_one(worker, fname, out);
+      fclose(out);
+      batch_emit(batch, i, text, length);
+    }
+  }
+  return NULL;
+}
+
+// Solves the `count` maze files in `files` with `engine` on `workers`
+// threads, 0 for one per online CPU. Outputs go to files in `outdir`
+// or, if it is NULL, to `out` in batch order. Prints the number of
+// mazes solved and the aggregate mazes per second to stdout. Returns 1
+// if any maze could not be loaded or its output written, 0 otherwise.
+int maze_batch_solve(char **files, int count, maze_engine_t *engine, int workers, char *outdir, FILE *out) {
+  if (engine->solve == maze_alt_solve) {
+    printf("ERROR: the alt engine cannot solve batches\n");
+    return 1;
+  }
+  if (workers <= 0) {
+    workers = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (workers < 1) {
+    workers = 1;
+  }
+  batch_t batch = {
+    .files = files, .count = count, .next = 0, .engine = engine, .outdir = outdir, .out = out,
+    .texts = calloc(count + 1, sizeof(char *)), .lengths = calloc(count + 1, sizeof(size_t)),
+    .written = 0,
+  };
+  pthread_mutex_init(&batch.lock, NULL);
+  fflush(out);
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  batchworker_t *pool = calloc(workers, sizeof(batchworker_t));
+  for (int w = 0; w < workers; w++) {
+    pool[w].batch = &batch;
+    pthread_create(&pool[w].tid, NULL, batch_worker, &pool[w]);
+  }
+  int solved = 0, unsolved = 0, failed = 0;
+  for (int w = 0; w < workers; w++) {
+    pthread_join(pool[w].tid, NULL);
+    solved += pool[w].solved;
+    unsolved += pool[w].unsolved;
+    failed += pool[w].failed;
+  }
+  fflush(out);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  printf("batch: %d mazes with %d workers: %d solved %d unsolved %d failed\n",
+         count, workers, solved, unsolved, failed);
+  printf("batch: %.3f s, %.1f mazes/s\n", secs, secs > 0 ? count / secs : 0.0);
+
+  pthread_mutex_destroy(&batch.lock);
+  free(batch.texts);
+  free(batch.lengths);
+  free(pool);
+  return failed > 0;
+}
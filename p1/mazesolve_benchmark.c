@@ -0,0 +1,306 @@
+// mazesolve_benchmark.c: times loading, solving, rebuilding and printing generated mazes
+#include "mazesolve.h"
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// For every style and size a maze is generated into a file once, then
+// for every engine it is loaded, solved, has its solution set and is
+// printed REPEATS times. The average time of each phase is reported
+// along with load and solve throughput in millions of tiles per
+// second. Engines must agree on the path length of every maze. With
+// -kernels each engine is run once per BFS kernel, instrumented and
+// production, to show the cost of the logging tests. With -binary the
+// maze is converted to the binary format and loads read that instead.
+// With -loaders text mazes are loaded once per loader, the mapped one
+// of mazesolve_load.c and the fscanf() one, and LD_GB/s gives the load
+// rate in bytes of maze file. Grid indices are ints so sizes stop at
+// BENCH_MAX_SIZE, whatever the generator can write.
+
+int REPEATS = 3;                // repetitions averaged for each maze and engine
+
+#define BENCH_MAX_SIZE 46338    // largest N whose NxN maze has at most MAZE_MAX_CELLS cells with its border
+
+// Nanoseconds on the monotonic clock
+static long bench_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Splits the comma separated `list` in place into at most `max` words
+// in `words`. Returns the number of words.
+static int split_list(char *list, char **words, int max) {
+  int count = 0;
+  for (char *word = strtok(list, ","); word != NULL && count < max; word = strtok(NULL, ",")) {
+    words[count++] = word;
+  }
+  return count;
+}
+
+// Prints one row of the results table, or the header if `style` is
+// NULL. Maze fields are left blank after the first engine of a maze.
+// `bytes` is the size of the maze file.
+static void print_result(char *style, int rows, int cols, double gen, char *engine,
+                         double load, double solve, double setsol, double print, int length,
+                         long bytes) {
+  if (style == NULL) {
+    printf("%-10s %6s %6s %6s %-14s %7s %7s %7s %7s %8s %7s %7s %7s\n",
+           "STYLE", "ROWS", "COLS", "GEN", "ENGINE", "LOAD", "SOLVE", "SETSOL", "PRINT",
+           "LENGTH", "LD_MT/s", "LD_GB/s", "SV_MT/s");
+    return;
+  }
+  double tiles = (double) rows * cols / 1e6;
+  if (gen >= 0) {
+    printf("%-10s %6d %6d %6.3f ", style, rows, cols, gen);
+  } else {
+    printf("%-10s %6s %6s %6s ", "", "", "", "");
+  }
+  printf("%-14s %7.4f %7.4f %7.4f %7.4f %8d %7.1f %7.2f %7.1f\n", engine, load, solve, setsol, print,
+         length, tiles / load, bytes / load / 1e9, tiles / solve);
+}
+
+int main(int argc, char *argv[]) {
+  char *size_words[64], *style_words[16], *engine_words[16], *kernel_words[2], *loader_words[2];
+  char default_sizes[] = "500,1000,2000";
+  char default_engines[] = "bfs";
+  char default_kernels[] = "production";
+  char default_loaders[] = "mapped";
+  int nsizes = split_list(default_sizes, size_words, 64);
+  int nengines = split_list(default_engines, engine_words, 16);
+  int nkernels = split_list(default_kernels, kernel_words, 2);
+  int nloaders = split_list(default_loaders, loader_words, 2);
+  int nstyles = 0;
+  uint64_t seed = 1234567;
+  double density = 0.3;
+  char *dir = "/tmp";
+  int binary = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-sizes") == 0 && i + 1 < argc) {
+      nsizes = split_list(argv[++i], size_words, 64);
+    } else if (strcmp(argv[i], "-styles") == 0 && i + 1 < argc) {
+      nstyles = split_list(argv[++i], style_words, 16);
+    } else if (strcmp(argv[i], "-engines") == 0 && i + 1 < argc) {
+      nengines = split_list(argv[++i], engine_words, 16);
+    } else if (strcmp(argv[i], "-kernels") == 0 && i + 1 < argc) {
+      nkernels = split_list(argv[++i], kernel_words, 2);
+    } else if (strcmp(argv[i], "-loaders") == 0 && i + 1 < argc) {
+      nloaders = split_list(argv[++i], loader_words, 2);
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-density") == 0 && i + 1 < argc) {
+      density = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-repeats") == 0 && i + 1 < argc) {
+      REPEATS = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-load-threads") == 0 && i + 1 < argc) {
+      LOAD_THREADS = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-binary") == 0) {
+      binary = 1;
+    } else if (strcmp(argv[i], "-dir") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (strcmp(argv[i], "-gen") == 0 && i + 3 < argc) {
+      // Write one maze to stdout rather than benchmarking
+      maze_style_t *style = maze_style_lookup(argv[i + 1]);
+      if (style == NULL) {
+        printf("ERROR: unknown style '%s'\n", argv[i + 1]);
+        return 1;
+      }
+      int rows = atoi(argv[i + 2]), cols = atoi(argv[i + 3]);
+      if (rows <= 0 || cols <= 0) {
+        printf("ERROR: maze size %s x %s must be positive\n", argv[i + 2], argv[i + 3]);
+        return 1;
+      }
+      maze_generate(stdout, style, rows, cols, seed, density);
+      return 0;
+    } else {
+      printf("usage: %s [-sizes N,N,...] [-styles S,S,...] [-engines E,E,...] [-seed N]\n", argv[0]);
+      printf("          [-density P] [-repeats N] [-dir DIR] [-gen STYLE ROWS COLS]\n");
+      printf("          [-kernels instrumented,production] [-loaders mapped,scanf] [-binary]\n");
+      printf("          [-load-threads N]\n");
+      printf("sizes: 1 to %d, the largest square maze that can be loaded\n", BENCH_MAX_SIZE);
+      printf("styles:");
+      for (int s = 0; maze_styles[s].name != NULL; s++) {
+        printf(" %s", maze_styles[s].name);
+      }
+      printf("\nengines: ");
+      maze_print_engines(stdout);
+      printf("\n");
+      return 1;
+    }
+  }
+  if (nstyles == 0) {
+    for (; maze_styles[nstyles].name != NULL; nstyles++) {
+      style_words[nstyles] = maze_styles[nstyles].name;
+    }
+  }
+  for (int z = 0; z < nsizes; z++) {
+    if (atoi(size_words[z]) <= 0) {
+      printf("ERROR: maze size '%s' must be positive\n", size_words[z]);
+      return 1;
+    }
+    if (atoi(size_words[z]) > BENCH_MAX_SIZE) {
+      printf("ERROR: maze size '%s' is above %d, the largest that can be loaded\n", size_words[z], BENCH_MAX_SIZE);
+      return 1;
+    }
+  }
+  maze_engine_t *engines[16];
+  for (int e = 0; e < nengines; e++) {
+    engines[e] = maze_engine_lookup(engine_words[e]);
+    if (engines[e] == NULL) {
+      printf("ERROR: unknown engine '%s'\n", engine_words[e]);
+      return 1;
+    }
+  }
+  int kernels[2];
+  for (int k = 0; k < nkernels; k++) {
+    if (strcmp(kernel_words[k], "instrumented") == 0) {
+      kernels[k] = 1;
+    } else if (strcmp(kernel_words[k], "production") == 0) {
+      kernels[k] = 0;
+    } else {
+      printf("ERROR: unknown kernel '%s'\n", kernel_words[k]);
+      return 1;
+    }
+  }
+  int loaders[2];
+  for (int l = 0; l < nloaders; l++) {
+    if (strcmp(loader_words[l], "mapped") == 0) {
+      loaders[l] = 1;
+    } else if (strcmp(loader_words[l], "scanf") == 0) {
+      loaders[l] = 0;
+    } else {
+      printf("ERROR: unknown loader '%s'\n", loader_words[l]);
+      return 1;
+    }
+  }
+  if (REPEATS < 1) {
+    REPEATS = 1;
+  }
+
+  printf("==== Maze Solving Benchmark ====\n");
+  printf("Running with REPEATS: %d seed: %llu density: %.2f\n", REPEATS, (unsigned long long) seed, density);
+  print_result(NULL, 0, 0, 0, NULL, 0, 0, 0, 0, 0, 0);
+
+  int devnull = open("/dev/null", O_WRONLY);
+  int ret = 0;
+  for (int s = 0; s < nstyles; s++) {
+    maze_style_t *style = maze_style_lookup(style_words[s]);
+    if (style == NULL) {
+      printf("ERROR: unknown style '%s'\n", style_words[s]);
+      ret = 1;
+      continue;
+    }
+    for (int z = 0; z < nsizes; z++) {
+      int size = atoi(size_words[z]);
+      char fname[4096];
+      snprintf(fname, sizeof(fname), "%s/mazesolve_bench_%d_%s_%d.txt", dir, (int) getpid(), style->name, size);
+      FILE *out = fopen(fname, "w");
+      if (out == NULL) {
+        printf("ERROR: could not write maze file %s\n", fname);
+        ret = 1;
+        continue;
+      }
+      long begin = bench_now_ns();
+      maze_generate(out, style, size, size, seed, density);
+      fclose(out);
+      double gen = (bench_now_ns() - begin) / 1e9;
+      char bin_name[sizeof(fname) + 4];
+      char *load_name = fname;
+      if (binary) {
+        snprintf(bin_name, sizeof(bin_name), "%s.bin", fname);
+        maze_t *maze = maze_from_file(fname);
+        int failed = maze == NULL || maze_save_binary(maze, bin_name);
+        if (maze != NULL) {
+          maze_free(maze);
+        }
+        unlink(fname);
+        if (failed) {
+          printf("ERROR: could not convert %s %d to a binary maze, skipping it\n", style->name, size);
+          unlink(bin_name);
+          ret = 1;
+          continue;
+        }
+        load_name = bin_name;
+      }
+
+      struct stat st;
+      long bytes = stat(load_name, &st) == 0 ? st.st_size : 0;
+
+      // One run per engine, kernel and loader, labelled with those
+      // of the kernels and loaders that vary
+      int first_length = 0, first_run = -1;  // length found by the first run that loaded
+      for (int run = 0; run < nengines * nkernels * nloaders; run++) {
+        int e = run / (nkernels * nloaders);
+        int k = run / nloaders % nkernels;
+        int l = run % nloaders;
+        BFS_INSTRUMENTED = kernels[k];
+        LOAD_MAPPED = loaders[l];
+        char label[32];
+        int n = snprintf(label, sizeof(label), "%s", engines[e]->name);
+        if (nkernels > 1) {
+          n += snprintf(label + n, sizeof(label) - n, ":%.4s", kernel_words[k]);
+        }
+        if (nloaders > 1) {
+          snprintf(label + n, sizeof(label) - n, "/%.4s", loader_words[l]);
+        }
+        long load = 0, solve = 0, setsol = 0, print = 0;
+        int length = -1, loaded = 1;
+        for (int r = 0; r < REPEATS; r++) {
+          long t0 = bench_now_ns();
+          maze_t *maze = maze_from_file(load_name);
+          long t1 = bench_now_ns();
+          if (maze == NULL) {
+            loaded = 0;
+            break;
+          }
+          engines[e]->solve(maze);
+          long t2 = bench_now_ns();
+          length = maze_set_solution(maze) ? maze->solution.path_len : -1;
+          long t3 = bench_now_ns();
+
+          // Printing is timed into /dev/null
+          fflush(stdout);
+          int saved = dup(STDOUT_FILENO);
+          dup2(devnull, STDOUT_FILENO);
+          long t4 = bench_now_ns();
+          maze_print_tiles(maze);
+          fflush(stdout);
+          long t5 = bench_now_ns();
+          dup2(saved, STDOUT_FILENO);
+          close(saved);
+
+          load += t1 - t0;
+          solve += t2 - t1;
+          setsol += t3 - t2;
+          print += t5 - t4;
+          maze_free(maze);
+          if (ALT_LANDMARKS != NULL) {
+            maze_alt_free(ALT_LANDMARKS);  // built for this maze by the alt engine
+            ALT_LANDMARKS = NULL;
+          }
+        }
+        if (!loaded) {
+          printf("ERROR: %s could not load %s %d, skipping the run\n", label, style->name, size);
+          ret = 1;
+          continue;
+        }
+        print_result(style->name, size, size, run == 0 ? gen : -1, label,
+                     load / 1e9 / REPEATS, solve / 1e9 / REPEATS, setsol / 1e9 / REPEATS,
+                     print / 1e9 / REPEATS, length, bytes);
+        if (first_run < 0) {
+          first_length = length;
+          first_run = run;
+        } else if (length != first_length) {
+          printf("ERROR: %s found path length %d but %s found %d\n",
+                 label, length, engines[first_run / (nkernels * nloaders)]->name, first_length);
+          ret = 1;
+        }
+      }
+      unlink(load_name);
+    }
+  }
+  close(devnull);
+  return ret;
+}
@@ -0,0 +1,315 @@
+// mazesolve_bfs.h: BFS functions of PROBLEM 3 written once and expanded per build
+//
+// This file has no include guard: mazesolve_funcs.c includes it twice
+// with different definitions of
+//
+//   BFS_NAME(name)  name of each function in the expansion
+//   BFS_LINKAGE     empty or static
+//   BFS_LOG(level)  condition for the log output of `level`
+//
+// The instrumented expansion keeps the public names and tests the
+// log level of the maze, LOG_LEVEL unless the maze was loaded with
+// its own, so its output is unchanged. The
+// production expansion appends _production to the names and defines
+// BFS_LOG() as 0 so the compiler drops every log statement, even
+// without optimization. maze_bfs_search() picks one by BFS_INSTRUMENTED.
+
+BFS_LINKAGE void BFS_NAME(maze_bfs_init)(maze_t *maze) {
+  maze_search_reset(maze);  // Predecessors, FOUND bits and the Start tile.
+
+  // Initialize the queue for BFS, sized from the maze so it rarely needs to grow.
+  if (maze->queue != NULL) {
+    rcqueue_free(maze->queue);
+  }
+  maze->queue = rcqueue_allocate_capacity(maze_queue_capacity(maze));  // Allocate the queue.
+  rcqueue_add_rear(maze->queue, maze->start_row, maze->start_col);  // Add the start tile to the queue.
+
+  // Log the initialization process if appropriate.
+  if (BFS_LOG(LOG_BFS_STATES)) {
+    printf("LOG: BFS initialization complete\n");
+    maze_print_state(maze);  // Print the maze state after initialization.
+  }
+}
+// PROBLEM 3: Initializes the maze for a BFS search. Allocates the
+// packed predecessor array then adjusts the start tile: sets its
+// distance to 0 if distances are tracked and sets its state to
+// FOUND. Allocates an empty rcqueue for the queue
+// in the maze using an appropriate function and then adds the Start
+// tile to it.
+//
+// LOGGING: If LOG_LEVEL >= LOG_BFS_STATES, after initialization is
+// complete. prints "BFS initialization compelte" and calls
+// maze_print_state().
+//
+// NOTES: This function is called within maze_bfs_iterate() to set up
+// the queue and Start tile before the search proceeds. It should not
+// be called outside of that context except during some testing of its
+// functionality and that of the BFS step function.
+//
+// EXAMPLE: The queue is initially empty (prints as null). After
+//          calling bfs_init(), the Start tile is set to FOUND so
+//          prints as its path_len of 0 and appears in the now
+//          allocated queue.
+//
+// print_maze_state(maze);
+//   ################:  0
+//   #S             #:  1
+//   # ### ###### # #:  2
+//   # ### ##E  #   #:  3
+//   # ### #### ##  #:  4
+//   #              #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   null queue
+// LOG_LEVEL = LOG_ALL;
+// maze_bfs_init(maze);
+// print_maze_state(maze);
+//   LOG: BFS initialization complete
+//   ################:  0
+//   #0             #:  1
+//   # ### ###### # #:  2
+//   # ### ##E  #   #:  3
+//   # ### #### ##  #:  4
+//   #              #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 1
+//   NN ROW COL
+//    0   1   1
+
+BFS_LINKAGE int BFS_NAME(maze_bfs_process_neighbor)(maze_t *maze, int cur_row, int cur_col, direction_t dir) {
+  int new_row, new_col;
+
+  // Compute the coordinates of the neighboring tile based on the direction.
+  new_row = cur_row + row_delta[dir];
+  new_col = cur_col + col_delta[dir];
+
+  // If the neighboring tile is blocked, skip it.
+  if (maze_tile_blocked(maze, new_row, new_col)) {
+    if (BFS_LOG(LOG_SKIPPED_TILES)) {
+      printf("LOG: Skipping BLOCKED tile at (%d,%d) \n", new_row, new_col);
+    }
+    return 0;  // Return 0 as the tile is blocked and cannot be processed.
+  }
+
+  int cur = MAZE_INDEX(maze, cur_row, cur_col);      // Current tile in the BFS.
+  int new_one = MAZE_INDEX(maze, new_row, new_col);  // Neighbor tile.
+
+  // If the neighboring tile has already been found, skip it.
+  if (BITSET_GET(maze->found, new_one)) {
+    if (BFS_LOG(LOG_SKIPPED_TILES)) {
+      printf("LOG: Skipping FOUND tile at (%d,%d)\n", new_row, new_col);
+    }
+    return 0;  // Return 0 as the tile has already been processed.
+  }
+
+  // The neighboring tile is not found so process it.
+  BITSET_SET(maze->found, new_one);          // Mark the neighbor tile as FOUND.
+  PRED_SET(maze->pred, new_one, dir);        // Record the direction it was reached from.
+  if (maze->dist != NULL) {
+    maze->dist[new_one] = maze->dist[cur] + 1;
+  }
+  rcqueue_add_rear(maze->queue, new_row, new_col);  // Add the neighbor to the queue.
+
+  // Log the newly found tile and its path if appropriate; the path is rebuilt from predecessors.
+  if (BFS_LOG(LOG_BFS_PATHS)) {
+    tile_t found = {.path = NULL, .path_len = -1};
+    maze_tile_path(maze, new_row, new_col, &found);
+    printf("LOG: Found tile at (%d,%d) with len %d path: ", new_row, new_col, found.path_len);
+    tile_print_path(&found, PATH_FORMAT_COMPACT);  // Print the compact path of the tile.
+    printf("\n");
+    free(found.path);
+  }
+
+  return 1;  // Return 1 as the neighbor was successfully processed.
+}
+// PROBLEM 3: Process the neighbor in direction `dir` from coordinates
+// `cur_row/cur_col`. Calculates the adjacent tiles row/col
+// coordinates using the row_delta[]/col_delta[] global array and
+// `dir`.  If the neighbor tile is blocked according to the
+// maze_tile_blocked() function, makes no changes and returns 0 as the
+// position cannot be reached. If the neighbor tile has state FOUND,
+// makes no changes and returns 0 as the tile has already been
+// processed in the BFS. Otherwise changes the neighbor tile to be a
+// Found tile: records `dir` as the neighbor's predecessor direction
+// (and its distance if tracked), changes the neighbor tile's state to
+// FOUND, and adds the neighbor tile to the maze search queue. This function
+// is used in BFS to propogate paths to all non-blocked neighbor
+// tiles and extend the search forntier.
+//
+// LOGGING:
+// 1. If LOG_LEVEL >= LOG_BFS_PATHS and the neighor tile's state
+//    changes from NOTFOUND to FOUND, print a message like:
+//      LOG: Found tile at (4,10) with len 14 path: SSSSEEEEEEEEEN
+//    with the coordinates, path_len, and COMPACT path for the newly
+//    found tile.
+// 2. If LOG_LEVEL >= LOG_SKIPPED_TILES and the neighbor tile is
+//    skipped as it is blocked or already found, print a message like
+//    one of
+//      LOG: Skipping BLOCKED tile at (6,13)
+//      LOG: Skipping FOUND tile at (5,12)
+//
+// EXAMPLE:
+// maze_print_state(maze);
+//   ################:  0
+//   #0123          #:  1
+//   #1### ###### # #:  2
+//   #2### ##E  #   #:  3
+//   #3### #### ##  #:  4
+//   #4             #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 2
+//   NN ROW COL
+//    0   1   4
+//    1   5   1
+// LOG_LEVEL = LOG_ALL; // above both LOG_BFS_PATHS and LOG_SKIPPED_TILES
+// maze_bfs_process_neighbor(maze, 1, 4, NORTH);
+//   LOG: Skipping BLOCKED tile at (0,4)
+// maze_bfs_process_neighbor(maze, 1, 4, SOUTH);
+//   LOG: Skipping BLOCKED tile at (2,4)
+// maze_bfs_process_neighbor(maze, 1, 4, WEST);
+//   LOG: Skipping FOUND tile at (1,3)
+// maze_bfs_process_neighbor(maze, 1, 4, EAST);
+//   LOG: Found tile at (1,5) with len 4 path: EEEE
+// maze_print_state(maze);
+//   ################:  0
+//   #01234         #:  1
+//   #1### ###### # #:  2
+//   #2### ##E  #   #:  3
+//   #3### #### ##  #:  4
+//   #4             #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 2
+//   NN ROW COL
+//    0   1   4
+//    1   5   1
+//    2   1   5
+
+BFS_LINKAGE int BFS_NAME(maze_bfs_step)(maze_t *maze) {
+  if (maze == NULL) {
+    printf("maze is NULL");
+    return 0;  // Return 0 if the maze pointer is NULL.
+  }
+
+  int row, col;
+  if (!rcqueue_get_front(maze->queue, &row, &col)) {  // Get the coordinates of the front tile in the queue.
+    printf("ERROR: BFS step on an empty queue\n");
+    return 0;  // Return 0 as there is nothing to process.
+  }
+
+  // Log the processing of neighbors for the front tile if appropriate.
+  if (BFS_LOG(LOG_BFS_STEPS)) {
+    printf("LOG: processing neighbors of (%d,%d)\n", row, col);
+  }
+
+  // Process all neighbors in the four directions (North, South, West, East).
+  for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+    BFS_NAME(maze_bfs_process_neighbor)(maze, row, col, dir_delta[i]);  // Process the neighbor in direction `i`.
+  }
+  rcqueue_remove_front(maze->queue);  // Remove the front tile from the queue.
+  maze->expanded++;                   // Count the expanded tile.
+
+  // Log the maze state after processing the step if appropriate.
+  if (BFS_LOG(LOG_BFS_STATES)) {
+    printf("LOG: maze state after BFS step\n");
+    maze_print_state(maze);  // Print the maze state.
+  }
+  return 1;  // Return 1 as the step was successfully processed.
+}
+// PROBLEM 3: Processes the tile in BFS which is at the front of the
+// maze search queue. For the front tile, iterates over the directions
+// in the global dir_delta[] array from index DELTA_START to less than
+// DELTA_COUNT which will be NORTH, SOUTH, WEST, EAST. Processes the
+// neighbors in each of these directions with an appropriate
+// function. Removes the front element of the search queue and
+// returns 1. Note: if this function is called when the maze queue is
+// empty, return 0 and print an error message though this case will
+// not be tested and should not arise if other parts of the program
+// are correct.
+//
+// LOGGING:
+// If LOG_LEVEL >= LOG_BFS_STEPS, print a message like
+//   LOG: processing neighbors of (5,1)
+// at the start of the function.
+//
+// If LOG_LEVEL >= LOG_BFS_STATES, prints a message and uses
+// maze_print_state() at the end of the function to show the maze
+// after processing finishes as in:
+//   LOG: maze state after BFS step
+//   ################:  0
+//   #01234         #:  1
+//   #1### ###### # #:  2
+//   #2### ##E  #   #:  3
+//   #3### #### ##  #:  4
+//   #45            #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 2
+//   NN ROW COL
+//    0   1   5
+//    1   5   2
+//
+// EXAMPLE:
+// maze_print_state(maze);
+//   ################:  0
+//   #0123456789a1  #:  1
+//   #1###5###### # #:  2
+//   #2###6##E  #   #:  3
+//   #3###7#### ##  #:  4
+//   #456789a12     #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 2
+//   NN ROW COL
+//    0   1  12
+//    1   5   9
+// LOG_LEVEL = LOG_ALL;
+// maze_bfs_step(maze);
+//   LOG: processing neighbors of (1,12)
+//   LOG: maze state after BFS step
+//   ################:  0
+//   #0123456789a12 #:  1
+//   #1###5######2# #:  2
+//   #2###6##E  #   #:  3
+//   #3###7#### ##  #:  4
+//   #456789a12     #:  5
+//   ################:  6
+//   0123456789012345
+//   0         1
+//   queue count: 3
+//   NN ROW COL
+//    0   5   9
+//    1   2  12
+//    2   1  13
+
+// Runs the BFS loop for maze_bfs_search().
+static int BFS_NAME(maze_bfs_run)(maze_t *maze, int stop_at_end) {
+  maze->expanded = 0;
+  if (maze->start_row < 0) {
+    return 0;  // Nothing to search from without a Start tile.
+  }
+  BFS_NAME(maze_bfs_init)(maze);  // Initialize the BFS search on the maze.
+  int step = 1;         // Initialize the step counter.
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+
+  // Continue iterating until the queue is empty or the End tile is reached.
+  while (maze->queue->count != 0) {
+    if (stop_at_end && BITSET_GET(maze->found, end)) {
+      break;
+    }
+    if (BFS_LOG(LOG_BFS_STEPS)) {
+      printf("LOG: BFS STEP %d\n", step);  // Log the current step.
+    }
+    BFS_NAME(maze_bfs_step)(maze);  // Process one step of the BFS.
+    step++;               // Increment the step counter.
+  }
+  return maze->end_row >= 0 && BITSET_GET(maze->found, end);
+}
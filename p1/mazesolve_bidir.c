@@ -0,0 +1,129 @@
+// mazesolve_bidir.c: bidirectional BFS from both Start and End
+#include "mazesolve.h"
+
+// Expands every tile in the current layer of `queue`, marking unseen
+// open neighbors in `seen` and recording the direction in `pred`. The
+// forward search records the incoming direction like the BFS; the
+// backward search from End records the direction leading back
+// towards End. Stops as soon as a neighbor already seen by the other
+// search is reached and returns 1 with the expanded tile and the
+// direction of that neighbor in `meet_idx`/`meet_dir`. Returns 0 once
+// the layer is exhausted without meeting.
+//
+// NOTES: Both searches expand whole layers so the first meeting is
+// always between the two current frontiers. Any tile behind a
+// frontier has all its neighbors seen by its own search, which would
+// have produced an earlier meeting. All meetings in a layer therefore
+// give the same shortest path length and the first one can be taken.
+static int bidir_expand_layer(maze_t *maze, rcqueue_t *queue, uint64_t *seen, unsigned char *pred,
+                              int backward, uint64_t *other, int *meet_idx, direction_t *meet_dir) {
+  int layer = queue->count;  // tiles at the current depth
+  for (int n = 0; n < layer; n++) {
+    int row, col;
+    rcqueue_get_front(queue, &row, &col);
+    rcqueue_remove_front(queue);
+    maze->expanded++;
+
+    int cur = MAZE_INDEX(maze, row, col);
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      int next = cur + DIR_OFFSET(maze, dir);
+      if (maze->grid[next] == WALL || BITSET_GET(seen, next)) {
+        continue;  // blocked or already seen by this search
+      }
+      if (BITSET_GET(other, next)) {
+        *meet_idx = cur;  // the two searches touch across this step
+        *meet_dir = dir;
+        return 1;
+      }
+      BITSET_SET(seen, next);
+      PRED_SET(pred, next, backward ? dir_opposite[dir] : dir);
+      if (!backward && maze->dist != NULL) {
+        maze->dist[next] = maze->dist[cur] + 1;
+      }
+      rcqueue_add_rear(queue, row + row_delta[dir], col + col_delta[dir]);
+    }
+  }
+  return 0;
+}
+
+// Completes the forward predecessors once the searches meet: steps
+// from the forward tile `from` in `dir` then follows the backward
+// directions to End, marking each tile FOUND with its incoming
+// direction so maze_set_solution() can walk back from End.
+static void bidir_join(maze_t *maze, unsigned char *bpred, int from, direction_t dir) {
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  int prev = from;
+  int idx = from + DIR_OFFSET(maze, dir);
+  while (1) {
+    BITSET_SET(maze->found, idx);
+    PRED_SET(maze->pred, idx, dir);
+    if (maze->dist != NULL) {
+      maze->dist[idx] = maze->dist[prev] + 1;
+    }
+    if (idx == end) {
+      break;
+    }
+    dir = PRED_GET(bpred, idx);  // next step towards End
+    prev = idx;
+    idx += DIR_OFFSET(maze, dir);
+  }
+}
+
+// Searches for a shortest Start to End path by alternately expanding
+// a full BFS layer from Start and from End, always growing the
+// smaller frontier, until the two meet. The forward search uses the
+// maze queue, FOUND bitset and predecessors as maze_bfs_solve() does;
+// the backward search keeps its own. On meeting, the backward half of
+// the path is written into the forward predecessors. Returns 1 if End
+// is reachable and leaves the number of expanded tiles from both
+// searches in maze->expanded.
+int maze_bidir_solve(maze_t *maze) {
+  maze->expanded = 0;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return 0;  // need both Start and End to search between them
+  }
+  maze_bfs_init(maze);  // forward search state starting from Start
+
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  if (start == end) {
+    return 1;
+  }
+
+  // Backward search state starting from End
+  long cells = MAZE_CELLS(maze);
+  uint64_t *bseen = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  unsigned char *bpred = calloc(PRED_BYTES(cells), sizeof(unsigned char));
+  rcqueue_t *bqueue = rcqueue_allocate_capacity(maze_queue_capacity(maze));
+  BITSET_SET(bseen, end);
+  rcqueue_add_rear(bqueue, maze->end_row, maze->end_col);
+
+  int met = 0;
+  int meet;
+  direction_t dir;
+  while (!met && maze->queue->count > 0 && bqueue->count > 0) {
+    if (maze->queue->count <= bqueue->count) {
+      // Forward step met the backward search: join across the step taken
+      if (bidir_expand_layer(maze, maze->queue, maze->found, maze->pred, 0, bseen, &meet, &dir)) {
+        bidir_join(maze, bpred, meet, dir);
+        met = 1;
+      }
+    } else {
+      // Backward step reached a forward tile: join from it back across the step
+      if (bidir_expand_layer(maze, bqueue, bseen, bpred, 1, maze->found, &meet, &dir)) {
+        bidir_join(maze, bpred, meet + DIR_OFFSET(maze, dir), dir_opposite[dir]);
+        met = 1;
+      }
+    }
+  }
+
+  if (met && maze->log_level >= LOG_BFS_STEPS) {
+    printf("LOG: bidirectional searches met after expanding %ld tiles\n", maze->expanded);
+  }
+
+  free(bseen);
+  free(bpred);
+  rcqueue_free(bqueue);
+  return met;
+}
@@ -0,0 +1,213 @@
+// mazesolve_binary.c: bit-packed binary maze files and text/binary converters
+#include "mazesolve.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// A binary maze file is a mazebinheader_t followed by one bit per tile,
+// set for WALL tiles, with each row padded to whole 64-bit words:
+//
+//   bit c&63 of word (r*words + c/64) is tile (r,c)
+//
+// The file is an eighth of the size of the text format and needs no
+// parsing. It is mmap()ed and any row is read in place with
+// MAZEBIN_ROW() without touching the rest of the file. Integers are
+// in the byte order of the machine that wrote the file. Only WALL,
+// Start and End are kept, so ONPATH tiles become OPEN; mazes with
+// terrain tiles costing more than 1 cannot be saved.
+
+// Words per row of a binary maze with `cols` columns
+#define MAZEBIN_WORDS(cols) (((long) (cols) + 63) / 64)
+
+// Bytes of a binary maze file of the given size
+static long mazebin_bytes(int rows, int cols) {
+  return sizeof(mazebinheader_t) + sizeof(uint64_t) * rows * MAZEBIN_WORDS(cols);
+}
+
+// 1 if row/col is a tile of the maze in `head` or a row of -1 for none
+static int mazebin_tile_ok(mazebinheader_t *head, int row, int col) {
+  return row == -1 || (row >= 0 && row < head->rows && col >= 0 && col < head->cols);
+}
+
+// Maps the binary maze file `fname` into memory. Returns NULL after
+// printing an error if it cannot be read or is not a binary maze.
+mazebin_t *maze_binary_open(char *fname) {
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    maze_load_error("ERROR: could not open file %s\n", fname);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return NULL;
+  }
+  void *base = st.st_size >= (off_t) sizeof(mazebinheader_t) ?
+    mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED) {
+    maze_load_error("ERROR: could not map binary maze %s\n", fname);
+    return NULL;
+  }
+
+  mazebinheader_t *head = base;
+  if (memcmp(head->magic, MAZEBIN_MAGIC, sizeof(head->magic)) != 0 ||
+      head->rows <= 0 || head->cols <= 0 || head->words != MAZEBIN_WORDS(head->cols) ||
+      !mazebin_tile_ok(head, head->start_row, head->start_col) ||
+      !mazebin_tile_ok(head, head->end_row, head->end_col) ||
+      st.st_size != mazebin_bytes(head->rows, head->cols)) {
+    maze_load_error("ERROR: %s is not a valid binary maze\n", fname);
+    munmap(base, st.st_size);
+    return NULL;
+  }
+
+  mazebin_t *bin = malloc(sizeof(mazebin_t));
+  bin->header = head;
+  bin->walls = (uint64_t *) (head + 1);
+  bin->bytes = st.st_size;
+  return bin;
+}
+
+// Unmaps a binary maze file.
+void maze_binary_close(mazebin_t *bin) {
+  munmap(bin->header, bin->bytes);
+  free(bin);
+}
+
+// Returns 1 if `fname` starts with MAZEBIN_MAGIC, 0 otherwise.
+int maze_binary_detect(char *fname) {
+  char magic[8];
+  FILE *handle = fopen(fname, "rb");
+  if (handle == NULL) {
+    return 0;
+  }
+  int found = fread(magic, 1, sizeof(magic), handle) == sizeof(magic) &&
+    memcmp(magic, MAZEBIN_MAGIC, sizeof(magic)) == 0;
+  fclose(handle);
+  return found;
+}
+
+// Builds a maze from a mapped binary maze file, logging by
+// `log_level` like maze_read_file(). Eight wall bits at a time are
+// expanded to eight tile types through a table. Returns NULL if the
+// maze cannot be allocated.
+maze_t *maze_from_binary(mazebin_t *bin, int log_level) {
+  mazebinheader_t *head = bin->header;
+  maze_t *maze = maze_allocate(head->rows, head->cols);
+  if (maze == NULL) {
+    return NULL;
+  }
+  maze->log_level = log_level;
+  if (log_level >= LOG_FILE_LOAD) {
+    printf("LOG: expecting %d rows and %d columns\n", head->rows, head->cols);
+    printf("LOG: reading binary tiles\n");
+  }
+
+  // Tile types of the 8 tiles of each byte of wall bits, lowest bit first
+  uint64_t expand[256];
+  for (int b = 0; b < 256; b++) {
+    unsigned char tiles[8];
+    for (int k = 0; k < 8; k++) {
+      tiles[k] = (b >> k) & 1 ? WALL : OPEN;
+    }
+    memcpy(&expand[b], tiles, 8);
+  }
+
+  int cols = head->cols;
+  for (int i = 0; i < head->rows; i++) {
+    uint64_t *row = MAZEBIN_ROW(bin, i);
+    unsigned char *grid = &MAZE_TYPE(maze, i, 0);
+    int j = 0;
+    for (; j + 8 <= cols; j += 8) {
+      memcpy(&grid[j], &expand[(row[j >> 6] >> (j & 63)) & 0xFF], 8);
+    }
+    for (; j < cols; j++) {
+      grid[j] = (row[j >> 6] >> (j & 63)) & 1 ? WALL : OPEN;
+    }
+  }
+
+  if (head->start_row >= 0) {
+    maze->start_row = head->start_row;
+    maze->start_col = head->start_col;
+    MAZE_TYPE(maze, maze->start_row, maze->start_col) = START;
+  }
+  if (head->end_row >= 0) {
+    maze->end_row = head->end_row;
+    maze->end_col = head->end_col;
+    MAZE_TYPE(maze, maze->end_row, maze->end_col) = END;
+  }
+  if (log_level >= LOG_FILE_LOAD) {
+    printf("LOG: START at (%d,%d) END at (%d,%d)\n",
+           maze->start_row, maze->start_col, maze->end_row, maze->end_col);
+  }
+  return maze;
+}
+
+// Writes `maze` to `fname` as a binary maze file. Returns 0 on
+// success and 1 after printing an error otherwise.
+int maze_save_binary(maze_t *maze, char *fname) {
+  for (int i = 0; i < maze->rows; i++) {
+    unsigned char *grid = &MAZE_TYPE(maze, i, 0);
+    for (int j = 0; j < maze->cols; j++) {
+      if (grid[j] >= COST2) {
+        printf("ERROR: terrain tile at (%d,%d) cannot be saved in a binary maze\n", i, j);
+        return 1;
+      }
+    }
+  }
+  FILE *fout = fopen(fname, "wb");
+  if (fout == NULL) {
+    printf("ERROR: could not write binary maze %s\n", fname);
+    return 1;
+  }
+  mazebinheader_t head = {
+    .magic = MAZEBIN_MAGIC, .rows = maze->rows, .cols = maze->cols,
+    .start_row = maze->start_row, .start_col = maze->start_col,
+    .end_row = maze->end_row, .end_col = maze->end_col,
+    .words = MAZEBIN_WORDS(maze->cols), .reserved = 0,
+  };
+  int ok = fwrite(&head, sizeof(head), 1, fout) == 1;
+  uint64_t *row = malloc(sizeof(uint64_t) * head.words);
+  for (int i = 0; ok && i < maze->rows; i++) {
+    memset(row, 0, sizeof(uint64_t) * head.words);
+    unsigned char *grid = &MAZE_TYPE(maze, i, 0);
+    for (int j = 0; j < maze->cols; j++) {
+      row[j >> 6] |= (uint64_t) (grid[j] == WALL) << (j & 63);
+    }
+    ok = fwrite(row, sizeof(uint64_t), head.words, fout) == (size_t) head.words;
+  }
+  free(row);
+  if (fclose(fout) != 0 || !ok) {
+    printf("ERROR: could not write binary maze %s\n", fname);
+    return 1;
+  }
+  return 0;
+}
+
+// Writes `maze` to `fname` in the text format read by
+// maze_from_file(). Returns 0 on success and 1 after printing an error
+// otherwise.
+int maze_save_text(maze_t *maze, char *fname) {
+  FILE *fout = fopen(fname, "w");
+  if (fout == NULL) {
+    printf("ERROR: could not write maze file %s\n", fname);
+    return 1;
+  }
+  fprintf(fout, "rows: %d cols: %d\n", maze->rows, maze->cols);
+  fprintf(fout, "tiles:\n");
+  char *line = malloc(maze->cols + 1);
+  for (int i = 0; i < maze->rows; i++) {
+    unsigned char *grid = &MAZE_TYPE(maze, i, 0);
+    for (int j = 0; j < maze->cols; j++) {
+      line[j] = tiletype_chars[grid[j]];
+    }
+    line[maze->cols] = '\n';
+    fwrite(line, 1, maze->cols + 1, fout);
+  }
+  free(line);
+  if (fclose(fout) != 0) {
+    printf("ERROR: could not write maze file %s\n", fname);
+    return 1;
+  }
+  return 0;
+}
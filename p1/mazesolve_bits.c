@@ -0,0 +1,247 @@
+// mazesolve_bits.c: bit-parallel wavefront BFS over 64-bit row words
+#include "mazesolve.h"
+#include <limits.h>             // for INT_MAX
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(BITS_NO_AVX2)
+#include <immintrin.h>
+#define BITS_HAVE_AVX2 1        // AVX2 row packing compiled in, used if the CPU has it; -DBITS_NO_AVX2 to leave out
+#endif
+
+// Each maze row is stored as a bitset of 64-bit words with one bit
+// per column followed by one zero word, and a zero row sits above and
+// below the maze, so a layer update can read the words around any
+// word without bounds checks. One BFS layer computes, for a whole
+// word of 64 tiles at once,
+//
+//   next = (north | south | west | east neighbors of frontier)
+//          & open & ~visited
+//
+// which replaces 64 queue pushes/pops with a few shifts and ORs.
+// A maze wavefront is thin, usually a bit or two per word, so each
+// layer only sweeps the words holding frontier bits and the words next
+// to them rather than whole rows.
+//
+// Rather than a full distance per tile, each visited tile keeps its
+// distance modulo 3 in two bit planes. Neighboring tiles differ in
+// distance by at most 1, so walking back from End to the neighbor
+// whose distance is one less mod 3 always follows a shortest path.
+
+typedef struct {                // bit-parallel BFS state
+  int rows, cols;               // maze size in tiles
+  int words;                    // words holding the columns of one row
+  long row_words;               // words per stored row including its zero word
+  long total;                   // words in each bit plane
+  uint64_t *open;               // 1 for each non-WALL tile
+  uint64_t *visited;            // 1 for each tile reached so far
+  uint64_t *front;              // tiles reached in the latest layer
+  uint64_t *next;               // tiles being reached in the current layer
+  uint64_t *mod3[2];            // low/high bit of each visited tile's distance mod 3
+} bitbfs_t;
+
+// Index of word `w` of row `r`, allowing r of -1/rows and w of -1/words
+#define BITS_WORD(b,r,w) (((long) (r)+1)*(b)->row_words + (w) + 1)
+#define BITS_GET(b,plane,r,c) (((b)->plane[BITS_WORD(b,r,(c)>>6)] >> ((c)&63)) & 1)
+
+// Computes the next layer for word `i` into b->next and returns it.
+static inline uint64_t bits_layer(bitbfs_t *b, long i) {
+  uint64_t *f = &b->front[i];
+  uint64_t east = (f[0] << 1) | (f[-1] >> 63);  // tiles one column right of the frontier
+  uint64_t west = (f[0] >> 1) | (f[+1] << 63);  // tiles one column left of the frontier
+  uint64_t vert = f[-b->row_words] | f[+b->row_words];
+  uint64_t n = (east | west | vert) & b->open[i] & ~b->visited[i];
+  b->next[i] = n;
+  return n;
+}
+
+// Sets the bits of `out` for the non-WALL tiles among the `cols`
+// tiles of `row` one tile at a time.
+static void bits_pack_scalar(unsigned char *row, int cols, uint64_t *out) {
+  for (int c = 0; c < cols; c++) {
+    if (row[c] != WALL) {
+      out[c >> 6] |= 1ULL << (c & 63);
+    }
+  }
+}
+
+#ifdef BITS_HAVE_AVX2
+// Same as bits_pack_scalar() but compares 32 tiles against WALL at
+// once and takes the byte sign bits as the 32 bits of a word half.
+__attribute__((target("avx2")))
+static void bits_pack_avx2(unsigned char *row, int cols, uint64_t *out) {
+  __m256i wall = _mm256_set1_epi8(WALL);
+  int c = 0;
+  for (; c + 32 <= cols; c += 32) {
+    __m256i tiles = _mm256_loadu_si256((__m256i *) &row[c]);
+    uint32_t walls = _mm256_movemask_epi8(_mm256_cmpeq_epi8(tiles, wall));
+    out[c >> 6] |= (uint64_t) (uint32_t) ~walls << (c & 63);
+  }
+  for (; c < cols; c++) {
+    if (row[c] != WALL) {
+      out[c >> 6] |= 1ULL << (c & 63);
+    }
+  }
+}
+#endif
+
+// Allocates the row bitsets for `maze` and fills in its open tiles,
+// packing rows with AVX2 when the CPU supports it.
+static bitbfs_t *bitbfs_allocate(maze_t *maze) {
+  bitbfs_t *b = malloc(sizeof(bitbfs_t));
+  b->rows = maze->rows;
+  b->cols = maze->cols;
+  b->words = BITSET_WORDS(maze->cols);
+  b->row_words = b->words + 1;
+  b->total = (long) (b->rows + 2) * b->row_words + 1;  // leading zero word before row -1
+  b->open = calloc(b->total, sizeof(uint64_t));
+  b->visited = calloc(b->total, sizeof(uint64_t));
+  b->front = calloc(b->total, sizeof(uint64_t));
+  b->next = calloc(b->total, sizeof(uint64_t));
+  b->mod3[0] = calloc(b->total, sizeof(uint64_t));
+  b->mod3[1] = calloc(b->total, sizeof(uint64_t));
+
+  void (*pack)(unsigned char *, int, uint64_t *) = bits_pack_scalar;
+#ifdef BITS_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    pack = bits_pack_avx2;
+  }
+#endif
+  for (int r = 0; r < maze->rows; r++) {
+    pack(&maze->grid[MAZE_INDEX(maze, r, 0)], maze->cols, &b->open[BITS_WORD(b, r, 0)]);
+  }
+  return b;
+}
+
+static void bitbfs_free(bitbfs_t *b) {
+  free(b->open);
+  free(b->visited);
+  free(b->front);
+  free(b->next);
+  free(b->mod3[0]);
+  free(b->mod3[1]);
+  free(b);
+}
+
+// Searches from Start to End one whole BFS layer at a time over row
+// bitsets. Once End is reached the path is rebuilt from the distances
+// mod 3 and each tile on it is marked FOUND with its predecessor
+// direction for maze_set_solution(). Returns 1 if End is reachable and leaves the
+// number of tiles visited in maze->expanded.
+int maze_bits_solve(maze_t *maze) {
+  maze->expanded = 0;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return 0;  // need both Start and End to search between them
+  }
+  maze_search_reset(maze);
+
+  bitbfs_t *b = bitbfs_allocate(maze);
+  int sr = maze->start_row, sc = maze->start_col;
+  long start_word = BITS_WORD(b, sr, sc >> 6);
+  long end_word = BITS_WORD(b, maze->end_row, maze->end_col >> 6);
+  uint64_t end_bit = 1ULL << (maze->end_col & 63);
+  b->front[start_word] |= 1ULL << (sc & 63);
+  b->visited[start_word] |= 1ULL << (sc & 63);
+
+  // Each word's stamp holds the last layer it was listed for, so it is
+  // swept at most once per layer; words without open tiles, including
+  // all the padding, get a stamp no layer reaches and are never swept.
+  int *stamp = calloc(b->total, sizeof(int));
+  for (long i = 0; i < b->total; i++) {
+    if (b->open[i] == 0) {
+      stamp[i] = INT_MAX;
+    }
+  }
+  long *front_list = malloc(sizeof(long) * b->total);  // words holding frontier bits
+  long *sweep_list = malloc(sizeof(long) * b->total);  // words to sweep this layer
+  long front_count = 1;
+  front_list[0] = start_word;
+
+  int dist = 0;
+  int reached = (b->visited[end_word] & end_bit) != 0;
+  while (!reached && front_count > 0) {
+    dist++;
+
+    // Only the words holding frontier bits, the words above and below
+    // them and, when a frontier bit sits at the edge of its word, the
+    // word beside it can gain tiles
+    long sweep_count = 0;
+    for (long f = 0; f < front_count; f++) {
+      long i = front_list[f];
+      long around[5] = {i, i - b->row_words, i + b->row_words,
+                        b->front[i] & 1 ? i - 1 : i,
+                        b->front[i] >> 63 ? i + 1 : i};
+      for (int a = 0; a < 5; a++) {
+        if (stamp[around[a]] < dist) {
+          stamp[around[a]] = dist;
+          sweep_list[sweep_count++] = around[a];
+        }
+      }
+    }
+
+    // Compute the new layer in each listed word and record its tiles
+    // as visited with this distance mod 3; the sweep list is reused
+    // for the words of the new frontier
+    uint64_t low = (dist % 3) & 1 ? ~0ULL : 0;
+    uint64_t high = (dist % 3) & 2 ? ~0ULL : 0;
+    long next_count = 0;
+    for (long n = 0; n < sweep_count; n++) {
+      long i = sweep_list[n];
+      uint64_t bits = bits_layer(b, i);
+      if (bits != 0) {
+        b->visited[i] |= bits;
+        b->mod3[0][i] |= bits & low;
+        b->mod3[1][i] |= bits & high;
+        sweep_list[next_count++] = i;
+      }
+    }
+
+    // Clear the old frontier and make the new layer the frontier
+    for (long f = 0; f < front_count; f++) {
+      b->front[front_list[f]] = 0;
+    }
+    uint64_t *tmp = b->front;
+    b->front = b->next;
+    b->next = tmp;
+    long *tmp_list = front_list;
+    front_list = sweep_list;
+    sweep_list = tmp_list;
+    front_count = next_count;
+    reached = (b->visited[end_word] & end_bit) != 0;
+  }
+  free(front_list);
+  free(sweep_list);
+  free(stamp);
+
+  // Count visited tiles as the expanded total
+  for (long i = 0; i < b->total; i++) {
+    maze->expanded += __builtin_popcountll(b->visited[i]);
+  }
+
+  // Walk back from End, each step to the neighbor one closer to Start
+  if (reached) {
+    int r = maze->end_row, c = maze->end_col;
+    for (int d = dist; d > 0; d--) {
+      int want = (d - 1) % 3;
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        direction_t dir = dir_delta[i];
+        int pr = r - row_delta[dir], pc = c - col_delta[dir];  // neighbor that steps `dir` into (r,c)
+        if (pr < 0 || pc < 0 || pr >= b->rows || pc >= b->cols || !BITS_GET(b, visited, pr, pc)) {
+          continue;
+        }
+        if ((int) (BITS_GET(b, mod3[0], pr, pc) | (BITS_GET(b, mod3[1], pr, pc) << 1)) == want) {
+          int idx = MAZE_INDEX(maze, r, c);
+          BITSET_SET(maze->found, idx);
+          PRED_SET(maze->pred, idx, dir);
+          if (maze->dist != NULL) {
+            maze->dist[idx] = d;
+          }
+          r = pr;
+          c = pc;
+          break;
+        }
+      }
+    }
+  }
+
+  bitbfs_free(b);
+  return reached;
+}
@@ -0,0 +1,123 @@
+// mazesolve_components.c: connected components of open tiles for O(1) reachability
+#include "mazesolve.h"
+
+// Two tiles are joined by a path exactly when they lie in the same
+// connected component of tiles that are not WALLs. The components are
+// labelled once with a two-pass scanline labeller:
+//
+//   1. Tiles are scanned in grid order. A tile takes the label of its
+//      west or north neighbor, or a new provisional label if both are
+//      WALLs. When both neighbors are labelled their labels are merged
+//      in a union-find forest, since the tile joins them.
+//   2. Every provisional label is replaced by a compact number, 1 up
+//      to the number of components, for the root of its tree.
+//
+// Both passes touch each tile once and only look back at tiles already
+// visited, so the labeller streams through the grid like the loaders.
+// Afterwards maze_connected() answers whether two tiles can reach each
+// other by comparing two labels, and a search between tiles of
+// different components can be skipped outright rather than flooding
+// everything reachable before giving up.
+
+// Root of provisional label `x`, halving the path to it on the way.
+static int comp_find(int *parent, int x) {
+  while (parent[x] != x) {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
+}
+
+// Merges the trees of provisional labels `a` and `b` and returns the
+// new root, the smaller of the two, so every label points to a smaller
+// one until it reaches its root.
+static int comp_union(int *parent, int a, int b) {
+  a = comp_find(parent, a);
+  b = comp_find(parent, b);
+  if (a < b) {
+    parent[b] = a;
+    return a;
+  }
+  parent[a] = b;
+  return b;
+}
+
+// Labels the connected components of the maze into maze->component,
+// replacing any earlier labels, and returns their number. WALL tiles
+// and the border are labelled 0. The labels describe the walls at the
+// time of the call and must be rebuilt after tiles change between
+// WALL and open.
+int maze_components_build(maze_t *maze) {
+  long cells = MAZE_CELLS(maze);
+  free(maze->component);
+  int *label = calloc(cells, sizeof(int));
+  maze->component = label;
+
+  // Provisional labels and their union-find parents; label 0 is WALL
+  int capacity = 1024, next = 1;
+  int *parent = malloc(sizeof(int) * capacity);
+  parent[0] = 0;
+
+  // First pass: label from the west and north neighbors, merging
+  // their labels when a tile joins them
+  for (int i = 0; i < maze->rows; i++) {
+    long row = MAZE_INDEX(maze, i, 0);
+    for (int j = 0; j < maze->cols; j++) {
+      long idx = row + j;
+      if (maze->grid[idx] == WALL) {
+        continue;
+      }
+      int west = label[idx - 1], north = label[idx - maze->stride];
+      if (west != 0 && north != 0) {
+        label[idx] = west == north ? west : comp_union(parent, west, north);
+      } else if (west != 0 || north != 0) {
+        label[idx] = west != 0 ? west : north;
+      } else {
+        if (next == capacity) {
+          capacity *= 2;
+          parent = realloc(parent, sizeof(int) * capacity);
+        }
+        parent[next] = next;
+        label[idx] = next++;
+      }
+    }
+  }
+
+  // Number the roots in order. Every other label points to a smaller
+  // one, already resolved when it is reached, so one sweep replaces
+  // each parent by the negated number of the label's component
+  int count = 0;
+  for (int x = 1; x < next; x++) {
+    parent[x] = parent[x] == x ? -(++count) : parent[parent[x]];
+  }
+
+  // Second pass: replace provisional labels by component numbers
+  for (long idx = 0; idx < cells; idx++) {
+    if (label[idx] != 0) {
+      label[idx] = -parent[label[idx]];
+    }
+  }
+  free(parent);
+
+  maze->component_count = count;
+  if (maze->log_level >= LOG_BFS_STEPS) {
+    printf("LOG: labelled %d components from %d provisional labels\n", count, next - 1);
+  }
+  return count;
+}
+
+// Returns 0 if the tiles at (sr,sc) and (er,ec) are known not to be
+// joined by any path: either is outside the maze, a WALL, or they lie
+// in different components. Returns 1 if they share a component or the
+// maze has no component labels, in which case only a search can tell.
+int maze_connected(maze_t *maze, int sr, int sc, int er, int ec) {
+  if (sr < 0 || sr >= maze->rows || sc < 0 || sc >= maze->cols ||
+      er < 0 || er >= maze->rows || ec < 0 || ec >= maze->cols) {
+    return 0;
+  }
+  if (maze->component == NULL) {
+    return MAZE_TYPE(maze, sr, sc) != WALL && MAZE_TYPE(maze, er, ec) != WALL;
+  }
+  int from = maze->component[MAZE_INDEX(maze, sr, sc)];
+  return from != 0 && from == maze->component[MAZE_INDEX(maze, er, ec)];
+}
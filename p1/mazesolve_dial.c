@@ -0,0 +1,129 @@
+// mazesolve_dial.c: Dijkstra over weighted terrain with Dial's bucket queue
+#include "mazesolve.h"
+
+// Entering a tile costs tile_costs[] of its type, 1 for OPEN and up to
+// TILE_COST_MAX for the COST2..COST9 terrain tiles written as digits
+// in maze files. Costs are small integers so the Dijkstra frontier is
+// kept in Dial's bucket queue rather than a heap: tiles wait in the
+// bucket of their cost from Start and are taken from the bucket of
+// the current cost until it is empty. A tile pushed while expanding
+// cost d costs at most d + TILE_COST_MAX, so only the buckets for
+// costs d..d+TILE_COST_MAX are ever in use and DIAL_BUCKETS of them
+// are reused in a ring. Pushing and popping are O(1) with no
+// comparisons; advancing to the next nonempty bucket skips at most
+// TILE_COST_MAX empty ones.
+
+#define DIAL_BUCKETS 16         // power of 2 above TILE_COST_MAX, buckets in the ring
+
+typedef struct {                // tiles waiting at one cost, popped last in first out
+  int *idx;                     // grid indices of the tiles
+  int count;                    // number of tiles in the bucket
+  int capacity;                 // allocated size of idx
+} dialbucket_t;
+
+// Adds the tile at grid index `idx` to `bucket`, doubling it when full.
+static void dial_push(dialbucket_t *bucket, int idx) {
+  if (bucket->count == bucket->capacity) {
+    bucket->capacity = bucket->capacity > 0 ? 2 * bucket->capacity : 64;
+    bucket->idx = realloc(bucket->idx, sizeof(int) * bucket->capacity);
+  }
+  bucket->idx[bucket->count++] = idx;
+}
+
+// Searches from Start with Dijkstra's algorithm, expanding tiles in
+// order of the summed cost of the tiles entered to reach them. Newly
+// reached or cheaper tiles get their predecessor direction recorded
+// and are pushed into the bucket of their new cost; entries left in
+// a bucket by a tile that became cheaper are skipped when popped.
+// Every expanded tile has its final cost so with `stop_at_end` the
+// search stops as soon as End is expanded and the predecessors give a
+// cheapest path; otherwise every reachable tile is expanded. Returns 1
+// if End is reachable, leaving its cost in maze->path_cost and the
+// number of expanded tiles in maze->expanded. If maze->dist is tracked
+// it gets the number of steps along each tile's cheapest path.
+int maze_dial_search(maze_t *maze, int stop_at_end) {
+  maze->expanded = 0;
+  maze->path_cost = -1;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return 0;  // need both Start and End to search between them
+  }
+  maze_search_reset(maze);
+
+  // Cost from Start of FOUND tiles and the tiles already expanded
+  long cells = MAZE_CELLS(maze);
+  int *cost = malloc(sizeof(int) * cells);
+  uint64_t *closed = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  dialbucket_t buckets[DIAL_BUCKETS] = {{0}};
+
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  cost[start] = 0;
+  dial_push(&buckets[0], start);
+  long waiting = 1;             // entries in all buckets
+
+  int solved = 0;
+  for (int d = 0; waiting > 0; d++) {
+    dialbucket_t *bucket = &buckets[d & (DIAL_BUCKETS - 1)];
+    while (bucket->count > 0) {
+      int cur = bucket->idx[--bucket->count];
+      waiting--;
+      if (cost[cur] != d || BITSET_GET(closed, cur)) {
+        continue;  // stale entry for a tile reached more cheaply
+      }
+      BITSET_SET(closed, cur);
+      maze->expanded++;
+      if (cur == end) {
+        solved = 1;
+        maze->path_cost = d;
+        if (stop_at_end) {
+          waiting = 0;
+          break;
+        }
+      }
+
+      int row = cur / maze->stride - 1;
+      int col = cur % maze->stride - 1;
+      if (maze->log_level >= LOG_BFS_STEPS) {
+        printf("LOG: processing neighbors of (%d,%d) at cost %d\n", row, col, d);
+      }
+
+      // Relax each open neighbor that is not yet expanded
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        direction_t dir = dir_delta[i];
+        int next = cur + DIR_OFFSET(maze, dir);
+        if (maze->grid[next] == WALL || BITSET_GET(closed, next)) {
+          continue;
+        }
+        int next_cost = d + tile_costs[maze->grid[next]];
+        if (BITSET_GET(maze->found, next) && cost[next] <= next_cost) {
+          continue;  // already reached at least as cheaply
+        }
+        BITSET_SET(maze->found, next);
+        PRED_SET(maze->pred, next, dir);
+        cost[next] = next_cost;
+        if (maze->dist != NULL) {
+          maze->dist[next] = maze->dist[cur] + 1;
+        }
+        dial_push(&buckets[next_cost & (DIAL_BUCKETS - 1)], next);
+        waiting++;
+      }
+    }
+  }
+
+  for (int b = 0; b < DIAL_BUCKETS; b++) {
+    free(buckets[b].idx);
+  }
+  free(closed);
+  free(cost);
+  return solved;
+}
+
+// Cheapest path from Start to End over weighted terrain.
+int maze_dial_solve(maze_t *maze) {
+  return maze_dial_search(maze, 1);
+}
+
+// Cheapest paths from Start to every reachable tile over weighted terrain.
+int maze_dial_flood(maze_t *maze) {
+  return maze_dial_search(maze, 0);
+}
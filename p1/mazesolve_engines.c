@@ -0,0 +1,40 @@
+// mazesolve_engines.c: table of search engines selectable by name
+#include "mazesolve.h"
+
+// Every engine searches from Start to End and leaves FOUND bits and
+// predecessor directions along a shortest path so maze_set_solution()
+// can rebuild it. The first entry is the default. All but dial count
+// every tile that is not a WALL as one step; dial finds the cheapest
+// path by tile_costs[] instead. Engines that can flood every reachable
+// tile for -flood name the function doing so; the goal-directed ones
+// have none.
+maze_engine_t maze_engines[] = {
+  {"bfs",      maze_bfs_solve,      maze_bfs_flood},      // BFS stopping once End is found
+  {"bidir",    maze_bidir_solve,    NULL},                // BFS from Start and End meeting in the middle
+  {"astar",    maze_astar_solve,    NULL},                // A* with the Manhattan distance to End
+  {"jps",      maze_jps_solve,      NULL},                // Jump Point Search for open rooms
+  {"bits",     maze_bits_solve,     NULL},                // BFS one layer at a time over 64-tile row words
+  {"parallel", maze_parallel_solve, maze_parallel_flood}, // BFS with each layer split across -threads threads
+  {"hybrid",   maze_hybrid_solve,   maze_hybrid_flood},   // BFS switching between top-down and bottom-up layers
+  {"alt",      maze_alt_solve,      NULL},                // A* with landmark distance bounds, see -alt/-landmarks
+  {"dial",     maze_dial_solve,     maze_dial_flood},     // Dijkstra by terrain cost with a bucket queue
+  {"multi",    maze_multi_solve,    maze_multi_flood},    // BFS from every Start to the nearest of every End
+  {NULL,       NULL,                NULL},
+};
+
+// Returns the engine with the given name or NULL if there is none.
+maze_engine_t *maze_engine_lookup(char *name) {
+  for (int i = 0; maze_engines[i].name != NULL; i++) {
+    if (strcmp(maze_engines[i].name, name) == 0) {
+      return &maze_engines[i];
+    }
+  }
+  return NULL;
+}
+
+// Prints the names of all engines separated by |
+void maze_print_engines(FILE *out) {
+  for (int i = 0; maze_engines[i].name != NULL; i++) {
+    fprintf(out, "%s%s", i > 0 ? "|" : "", maze_engines[i].name);
+  }
+}
@@ -0,0 +1,506 @@
+// mazesolve_extern.c: out-of-core BFS over row bands kept on disk for mazes larger than memory
+#include "mazesolve.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// maze_from_file() holds the whole grid and all search state in memory.
+// The external BFS instead streams the maze file once into bands of
+// consecutive rows on disk, each stored as three fixed-size records
+//
+//   walls.bin  1 bit per tile, set for WALL
+//   seen.bin   1 bit per tile, set once the tile is FOUND
+//   pred.bin   2-bit incoming direction per FOUND tile
+//
+// and only a few bands are resident at a time, read and written back
+// whole with one pread()/pwrite() each. The search is level
+// synchronous: the candidates of the next layer in each band are
+// buffered per band and appended to a file in the work directory when
+// the buffer fills. A layer processes the bands that have candidates,
+// sweeping down and up on alternate layers; each candidate that is open
+// and not yet seen is marked with its predecessor and pushes its
+// neighbors as candidates of the next layer into its own band or the
+// bands above and below. Searches that stay within a band, as in long
+// corridors, never touch the disk since the band stays resident.
+//
+// The memory budget is split between EXTERN_SLOTS resident bands,
+// which sets the number of rows per band. Candidate buffers add
+// EXTERN_CHUNK entries per band with a pending frontier.
+
+#define EXTERN_SLOTS 4          // bands resident at once
+#define EXTERN_CHUNK 4096       // candidates buffered per band and layer parity before spilling
+#define EXTERN_MAX_BAND_TILES (1L << 29)  // keeps local index*4+direction within 32 bits
+#define EXTERN_PATH_MAX 4096    // longest path of a file in the work directory
+
+typedef struct {                // one band of rows resident in memory
+  int band;                     // band held, -1 if the slot is empty
+  uint64_t *walls;              // WALL bits of the band's tiles, row-major
+  uint64_t *seen;               // bits of the band's tiles FOUND so far
+  unsigned char *pred;          // packed predecessor directions of the band's tiles
+  int dirty;                    // 1 if seen or pred changed since the band was read
+  long used;                    // clock of the last use, the oldest is evicted first
+} extslot_t;
+
+typedef struct {                // candidates of one band for one layer parity
+  uint32_t *buf;                // buffered entries local_index*4 + direction-NORTH
+  int buffered;                 // entries in buf
+  long spilled;                 // entries appended to the band's candidate file
+} extcand_t;
+
+typedef struct {                // state of one external BFS
+  char *dir;                    // work directory holding the band files
+  int rows, cols;               // size of the maze
+  int band_rows;                // rows per band, the last band may have fewer
+  int bands;                    // number of bands
+  long band_tiles;              // tiles in a full band
+  long band_words;              // words of a band's walls/seen record
+  long pred_bytes;              // bytes of a band's pred record
+  int walls_fd, seen_fd, pred_fd; // band files
+  extslot_t slots[EXTERN_SLOTS]; // resident bands
+  long clock;                   // counts band uses for LRU eviction
+  extcand_t *cand[2];           // candidates of each band for even/odd layers
+  int *active[2];               // bands with candidates for even/odd layers
+  int active_count[2];          // number of bands in each active list
+  uint32_t *chunk;              // buffer for reading spilled candidates
+  long band_loads;              // bands read into a slot
+  long bytes_read, bytes_written; // disk traffic of band records and candidates
+} extbfs_t;
+
+// Makes "dir/name" into `path` which has room for EXTERN_PATH_MAX bytes.
+static void extern_path(extbfs_t *ext, char *path, char *name) {
+  snprintf(path, EXTERN_PATH_MAX, "%s/%s", ext->dir, name);
+}
+
+// Orders band numbers for qsort(), increasing or decreasing
+static int extern_band_up(const void *a, const void *b) {
+  return *(const int *) a - *(const int *) b;
+}
+static int extern_band_down(const void *a, const void *b) {
+  return *(const int *) b - *(const int *) a;
+}
+
+// Reads or writes exactly `bytes` at `offset` of `fd`, printing an
+// error and returning 1 on failure.
+static int extern_io(extbfs_t *ext, int fd, void *buf, long bytes, off_t offset, int write) {
+  char *p = buf;
+  while (bytes > 0) {
+    ssize_t n = write ? pwrite(fd, p, bytes, offset) : pread(fd, p, bytes, offset);
+    if (n <= 0) {
+      printf("ERROR: %s of band file failed: %s\n", write ? "write" : "read", n < 0 ? strerror(errno) : "end of file");
+      return 1;
+    }
+    if (write) {
+      ext->bytes_written += n;
+    } else {
+      ext->bytes_read += n;
+    }
+    p += n;
+    bytes -= n;
+    offset += n;
+  }
+  return 0;
+}
+
+// Returns the number of rows in band `b`.
+static int extern_band_rows(extbfs_t *ext, int b) {
+  int rows = ext->rows - b * ext->band_rows;
+  return rows < ext->band_rows ? rows : ext->band_rows;
+}
+
+// Writes the seen and pred records of the band in `slot` back if changed.
+static int extern_writeback(extbfs_t *ext, extslot_t *slot) {
+  if (slot->band < 0 || !slot->dirty) {
+    return 0;
+  }
+  slot->dirty = 0;
+  return extern_io(ext, ext->seen_fd, slot->seen, sizeof(uint64_t) * ext->band_words,
+                   (off_t) slot->band * ext->band_words * sizeof(uint64_t), 1) ||
+         extern_io(ext, ext->pred_fd, slot->pred, ext->pred_bytes,
+                   (off_t) slot->band * ext->pred_bytes, 1);
+}
+
+// Returns the slot holding band `b`, reading it in place of the least
+// recently used band if it is not resident, or NULL on an I/O error.
+static extslot_t *extern_band(extbfs_t *ext, int b) {
+  extslot_t *victim = &ext->slots[0];
+  for (int s = 0; s < EXTERN_SLOTS; s++) {
+    extslot_t *slot = &ext->slots[s];
+    if (slot->band == b) {
+      slot->used = ++ext->clock;
+      return slot;
+    }
+    if (slot->used < victim->used) {
+      victim = slot;
+    }
+  }
+  if (extern_writeback(ext, victim)) {
+    return NULL;
+  }
+  victim->band = b;
+  victim->used = ++ext->clock;
+  ext->band_loads++;
+  off_t words_at = (off_t) b * ext->band_words * sizeof(uint64_t);
+  if (extern_io(ext, ext->walls_fd, victim->walls, sizeof(uint64_t) * ext->band_words, words_at, 0) ||
+      extern_io(ext, ext->seen_fd, victim->seen, sizeof(uint64_t) * ext->band_words, words_at, 0) ||
+      extern_io(ext, ext->pred_fd, victim->pred, ext->pred_bytes, (off_t) b * ext->pred_bytes, 0)) {
+    victim->band = -1;
+    return NULL;
+  }
+  return victim;
+}
+
+// Appends the buffered candidates of band `b` for `parity` to its file.
+static int extern_spill(extbfs_t *ext, int b, int parity) {
+  extcand_t *cand = &ext->cand[parity][b];
+  char name[64], path[EXTERN_PATH_MAX];
+  snprintf(name, sizeof(name), "cand_%d_%d.bin", b, parity);
+  extern_path(ext, path, name);
+  int fd = open(path, O_WRONLY | O_CREAT, 0600);
+  if (fd < 0) {
+    printf("ERROR: could not open candidate file %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  int ret = extern_io(ext, fd, cand->buf, sizeof(uint32_t) * cand->buffered,
+                      (off_t) cand->spilled * sizeof(uint32_t), 1);
+  close(fd);
+  cand->spilled += cand->buffered;
+  cand->buffered = 0;
+  return ret;
+}
+
+// Adds tile `local` of band `b`, reached by a step in direction `dir`,
+// as a candidate for the layer of `parity`.
+static int extern_push(extbfs_t *ext, int b, long local, direction_t dir, int parity) {
+  extcand_t *cand = &ext->cand[parity][b];
+  if (cand->buffered == 0 && cand->spilled == 0) {
+    ext->active[parity][ext->active_count[parity]++] = b;
+  }
+  if (cand->buf == NULL) {
+    cand->buf = malloc(sizeof(uint32_t) * EXTERN_CHUNK);
+  }
+  cand->buf[cand->buffered++] = (uint32_t) (local * 4 + (dir - NORTH));
+  if (cand->buffered == EXTERN_CHUNK) {
+    return extern_spill(ext, b, parity);
+  }
+  return 0;
+}
+
+// Pushes the neighbors of tile `local` in the band of `slot` as
+// candidates for the layer of `parity`. Neighbors in the same band
+// that are WALL or already seen are dropped right away; neighbors in
+// other bands are checked when their band is processed.
+static int extern_expand(extbfs_t *ext, extslot_t *slot, long local, int parity) {
+  int b = slot->band;
+  int row = local / ext->cols, col = local % ext->cols;
+  int rows = extern_band_rows(ext, b);
+  for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+    direction_t dir = dir_delta[i];
+    int r = row + row_delta[dir], c = col + col_delta[dir];
+    if (c < 0 || c >= ext->cols) {
+      continue;
+    }
+    int ret = 0;
+    if (r < 0) {
+      ret = b > 0 && extern_push(ext, b - 1, (long) (ext->band_rows - 1) * ext->cols + c, dir, parity);
+    } else if (r >= rows) {
+      ret = b + 1 < ext->bands && extern_push(ext, b + 1, c, dir, parity);
+    } else {
+      long n = (long) r * ext->cols + c;
+      if (!BITSET_GET(slot->walls, n) && !BITSET_GET(slot->seen, n)) {
+        ret = extern_push(ext, b, n, dir, parity);
+      }
+    }
+    if (ret) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Streams the maze text in `fin` into the walls file one band at a
+// time and sets the row/col of the Start and End tiles in `start` and
+// `end`, which stay -1 if the maze has none.
+// Tiles are read exactly as maze_from_file() reads them.
+static int extern_load_walls(extbfs_t *ext, FILE *fin, int *start, int *end) {
+  uint64_t *walls = calloc(ext->band_words, sizeof(uint64_t));
+  start[0] = start[1] = end[0] = end[1] = -1;
+  int ret = 0;
+  char c;
+  int eof = 0;
+  for (int b = 0; b < ext->bands && !ret; b++) {
+    memset(walls, 0, sizeof(uint64_t) * ext->band_words);
+    int rows = extern_band_rows(ext, b);
+    for (int r = 0; r < rows; r++) {
+      for (int col = 0; col < ext->cols && !eof; col++) {
+        if (fscanf(fin, "%c", &c) != 1) {
+          eof = 1;  // file ended early; remaining tiles stay open like NOTSET tiles
+          break;
+        }
+        if (c == '\n') {
+          col--;
+          continue;
+        }
+        int row = b * ext->band_rows + r;
+        if (c == tiletype_chars[WALL]) {
+          BITSET_SET(walls, (long) r * ext->cols + col);
+        } else if (c == tiletype_chars[START]) {
+          start[0] = row;
+          start[1] = col;
+        } else if (c == tiletype_chars[END]) {
+          end[0] = row;
+          end[1] = col;
+        }
+      }
+    }
+    ret = extern_io(ext, ext->walls_fd, walls, sizeof(uint64_t) * ext->band_words,
+                    (off_t) b * ext->band_words * sizeof(uint64_t), 1);
+  }
+  free(walls);
+  return ret;
+}
+
+// Walks the predecessors back from End to Start band by band, writing
+// the `len` directions of the path into the file "path.bin", then
+// prints them to `out` in compact form.
+static int extern_print_path(extbfs_t *ext, int *start, int *end, long len, FILE *out) {
+  char path[EXTERN_PATH_MAX];
+  extern_path(ext, path, "path.bin");
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    printf("ERROR: could not open path file %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  unlink(path);  // removed once closed
+  long bufsize = EXTERN_CHUNK * 16;
+  unsigned char *buf = malloc(bufsize);
+  int row = end[0], col = end[1];
+  int ret = 0;
+
+  // Fill the buffer from its back as the path is walked backward
+  long pos = len;
+  while (pos > 0 && !ret) {
+    long lo = pos > bufsize ? pos - bufsize : 0;
+    for (long i = pos - 1; i >= lo; i--) {
+      int b = row / ext->band_rows;
+      extslot_t *slot = extern_band(ext, b);
+      if (slot == NULL) {
+        ret = 1;
+        break;
+      }
+      direction_t dir = PRED_GET(slot->pred, (long) (row - b * ext->band_rows) * ext->cols + col);
+      buf[i - lo] = dir;
+      row -= row_delta[dir];
+      col -= col_delta[dir];
+    }
+    ret = ret || extern_io(ext, fd, buf, pos - lo, lo, 1);
+    pos = lo;
+  }
+  if (!ret && (row != start[0] || col != start[1])) {
+    printf("ERROR: predecessors from End do not lead back to Start\n");
+    ret = 1;
+  }
+
+  if (!ret) {
+    fprintf(out, "path length: %ld\n", len);
+    for (pos = 0; pos < len && !ret; pos += bufsize) {
+      long n = len - pos < bufsize ? len - pos : bufsize;
+      ret = extern_io(ext, fd, buf, n, pos, 0);
+      for (long i = 0; i < n && !ret; i++) {
+        fputs(direction_compact_strs[buf[i]], out);
+      }
+    }
+    fputc('\n', out);
+  }
+  free(buf);
+  close(fd);
+  return ret;
+}
+
+// Creates band file `name` in the work directory sized for all bands
+// of `record` bytes each; the sparse file reads as zeros.
+static int extern_create(extbfs_t *ext, char *name, long record) {
+  char path[EXTERN_PATH_MAX];
+  extern_path(ext, path, name);
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || ftruncate(fd, (off_t) record * ext->bands) != 0) {
+    printf("ERROR: could not create band file %s: %s\n", path, strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  unlink(path);  // removed once closed
+  return fd;
+}
+
+// Solves the maze in the text file `fname` without loading it into
+// memory. Band files and spilled candidates go in the existing
+// directory `dir` and are removed when done; at most about `budget`
+// bytes of bands are resident. Prints the path length and compact
+// path from Start to End, or "No solution found.", to `out` and with
+// `stats` the tiles expanded and disk traffic. Paths have the same
+// length as those of maze_bfs_solve() though ties may be broken
+// differently. Returns 0 on success and 1 on an error.
+int maze_extern_solve(char *fname, char *dir, long budget, int stats, FILE *out) {
+  FILE *fin = fopen(fname, "r");
+  if (fin == NULL) {
+    printf("ERROR: could not open file %s\n", fname);
+    return 1;
+  }
+  extbfs_t ext;
+  memset(&ext, 0, sizeof(ext));
+  ext.dir = dir;
+  if (!maze_read_header(fin, &ext.rows, &ext.cols)) {
+    printf("ERROR: %s does not start with the maze size\n", fname);
+    fclose(fin);
+    return 1;
+  }
+
+  // Each tile takes 4 bits when resident: walls, seen and 2 pred bits
+  long row_bytes = ((long) ext.cols + 1) / 2;
+  long band_rows = budget / EXTERN_SLOTS / row_bytes;
+  if (band_rows * ext.cols > EXTERN_MAX_BAND_TILES) {
+    band_rows = EXTERN_MAX_BAND_TILES / ext.cols;
+  }
+  ext.band_rows = band_rows < 1 ? 1 : band_rows > ext.rows ? ext.rows : band_rows;
+  ext.bands = (ext.rows + ext.band_rows - 1) / ext.band_rows;
+  ext.band_tiles = (long) ext.band_rows * ext.cols;
+  ext.band_words = BITSET_WORDS(ext.band_tiles);
+  ext.pred_bytes = PRED_BYTES(ext.band_tiles);
+  if (LOG_LEVEL >= LOG_BFS_STEPS) {
+    printf("LOG: external BFS with %d bands of %d rows\n", ext.bands, ext.band_rows);
+  }
+
+  ext.walls_fd = extern_create(&ext, "walls.bin", sizeof(uint64_t) * ext.band_words);
+  ext.seen_fd = extern_create(&ext, "seen.bin", sizeof(uint64_t) * ext.band_words);
+  ext.pred_fd = extern_create(&ext, "pred.bin", ext.pred_bytes);
+  int start[2] = {-1, -1}, end[2] = {-1, -1};  // stay -1 if the walls are never loaded
+  int ret = ext.walls_fd < 0 || ext.seen_fd < 0 || ext.pred_fd < 0 ||
+            extern_load_walls(&ext, fin, start, end);
+  fclose(fin);
+
+  for (int s = 0; s < EXTERN_SLOTS; s++) {
+    ext.slots[s].band = -1;
+    ext.slots[s].walls = malloc(sizeof(uint64_t) * ext.band_words);
+    ext.slots[s].seen = malloc(sizeof(uint64_t) * ext.band_words);
+    ext.slots[s].pred = malloc(ext.pred_bytes);
+  }
+  for (int p = 0; p < 2; p++) {
+    ext.cand[p] = calloc(ext.bands, sizeof(extcand_t));
+    ext.active[p] = malloc(sizeof(int) * ext.bands);
+  }
+  ext.chunk = malloc(sizeof(uint32_t) * EXTERN_CHUNK);
+
+  // Level-synchronous search from Start, stopping once End is seen
+  long expanded = 0, depth = 0;
+  int reached = 0;
+  if (!ret && start[0] >= 0) {
+    int b = start[0] / ext.band_rows;
+    ret = extern_push(&ext, b, (long) (start[0] - b * ext.band_rows) * ext.cols + start[1], NORTH, 0);
+  }
+  int end_band = end[0] >= 0 ? end[0] / ext.band_rows : -1;
+  long end_local = end[0] >= 0 ? (long) (end[0] - end_band * ext.band_rows) * ext.cols + end[1] : -1;
+  for (int parity = 0; !ret && !reached && ext.active_count[parity] > 0; parity ^= 1, depth++) {
+    // Sweep the bands up and down on alternate layers so the bands
+    // processed last in a layer are still resident at the start of the next
+    qsort(ext.active[parity], ext.active_count[parity], sizeof(int), parity ? extern_band_down : extern_band_up);
+    if (LOG_LEVEL >= LOG_BFS_STEPS) {
+      printf("LOG: external BFS layer %ld in %d bands\n", depth, ext.active_count[parity]);
+    }
+    for (int a = 0; a < ext.active_count[parity] && !ret && !reached; a++) {
+      int b = ext.active[parity][a];
+      extcand_t *cand = &ext.cand[parity][b];
+      extslot_t *slot = extern_band(&ext, b);
+      if (slot == NULL) {
+        ret = 1;
+        break;
+      }
+
+      // Spilled candidates come first, read back in chunks, then the buffer
+      char name[64], path[EXTERN_PATH_MAX];
+      snprintf(name, sizeof(name), "cand_%d_%d.bin", b, parity);
+      extern_path(&ext, path, name);
+      int fd = cand->spilled > 0 ? open(path, O_RDONLY) : -1;
+      if (cand->spilled > 0 && fd < 0) {
+        printf("ERROR: could not open candidate file %s: %s\n", path, strerror(errno));
+        ret = 1;
+        break;
+      }
+      for (long done = 0; done < cand->spilled + cand->buffered && !ret && !reached; ) {
+        uint32_t *entries = cand->buf;
+        long n = cand->buffered;
+        if (done < cand->spilled) {
+          n = cand->spilled - done < EXTERN_CHUNK ? cand->spilled - done : EXTERN_CHUNK;
+          entries = ext.chunk;
+          ret = extern_io(&ext, fd, entries, sizeof(uint32_t) * n, (off_t) done * sizeof(uint32_t), 0);
+        }
+        for (long e = 0; e < n && !ret; e++) {
+          long local = entries[e] >> 2;
+          if (BITSET_GET(slot->walls, local) || BITSET_GET(slot->seen, local)) {
+            continue;
+          }
+          BITSET_SET(slot->seen, local);
+          PRED_SET(slot->pred, local, (entries[e] & 3) + NORTH);
+          slot->dirty = 1;
+          expanded++;
+          if (b == end_band && local == end_local) {
+            reached = 1;
+            break;
+          }
+          ret = extern_expand(&ext, slot, local, parity ^ 1);
+        }
+        done += n;
+      }
+      if (fd >= 0) {
+        close(fd);
+        unlink(path);
+      }
+      cand->spilled = 0;
+      cand->buffered = 0;
+    }
+    ext.active_count[parity] = 0;
+  }
+  depth--;  // the loop counted the layer that reached End or ran dry
+
+  if (!ret && reached) {
+    ret = extern_print_path(&ext, start, end, depth, out);
+  } else if (!ret) {
+    fprintf(out, "No solution found.\n");
+  }
+  if (stats) {
+    fprintf(out, "tiles expanded: %ld\n", expanded);
+    fprintf(out, "bands: %d of %d rows, band loads: %ld, MB read: %.1f, MB written: %.1f\n",
+            ext.bands, ext.band_rows, ext.band_loads, ext.bytes_read / 1e6, ext.bytes_written / 1e6);
+  }
+
+  // Leftover candidate files when stopping early at End
+  for (int p = 0; p < 2; p++) {
+    for (int b = 0; b < ext.bands; b++) {
+      if (ext.cand[p][b].spilled > 0) {
+        char name[64], path[EXTERN_PATH_MAX];
+        snprintf(name, sizeof(name), "cand_%d_%d.bin", b, p);
+        extern_path(&ext, path, name);
+        unlink(path);
+      }
+      free(ext.cand[p][b].buf);
+    }
+    free(ext.cand[p]);
+    free(ext.active[p]);
+  }
+  for (int s = 0; s < EXTERN_SLOTS; s++) {
+    free(ext.slots[s].walls);
+    free(ext.slots[s].seen);
+    free(ext.slots[s].pred);
+  }
+  free(ext.chunk);
+  if (ext.walls_fd >= 0) {
+    close(ext.walls_fd);
+  }
+  if (ext.seen_fd >= 0) {
+    close(ext.seen_fd);
+  }
+  if (ext.pred_fd >= 0) {
+    close(ext.pred_fd);
+  }
+  return ret;
+}
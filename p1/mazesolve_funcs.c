@@ -13,13 +13,25 @@
 // execution proceeds.
 int LOG_LEVEL = 0;
 
+// Selects the BFS kernel run by maze_bfs_search(): nonzero for the
+// instrumented one that logs by LOG_LEVEL, 0 for the production one
+// built without any logging.
+int BFS_INSTRUMENTED = 1;
+
+// Stream that errors loading a maze are printed to, stdout if NULL.
+// Each thread has its own so batch workers can print the errors of a
+// maze into that maze's output.
+__thread FILE *LOAD_ERRORS = NULL;
+
 // Pre-specified order in which neighbor tiles should be checked for
 // compatibility with tests.
 direction_t dir_delta[5] = {NONE, NORTH, SOUTH, WEST, EAST};
 int row_delta[5] = {+0, -1, +1, +0, +0};
 int col_delta[5] = {+0, +0, +0, -1, +1};
-#define DELTA_START 1
-#define DELTA_COUNT 5
+
+// Direction that undoes each direction, used when searches run
+// backwards from the End tile.
+direction_t dir_opposite[5] = {NONE, SOUTH, NORTH, EAST, WEST};
 
 // strings to print for compact directions
 char *direction_compact_strs[5] = {
@@ -39,8 +51,6 @@ char *direction_verbose_strs[5] = {
     "EAST",   // EAST
 };
 
-#define TILETYPE_COUNT 6
-
 // strings to print for each tile type
 char tiletype_chars[TILETYPE_COUNT] = {
     '?',  // NOTSET = 0,
@@ -49,6 +59,33 @@ char tiletype_chars[TILETYPE_COUNT] = {
     '.',  // ONPATH,
     'S',  // START,
     'E',  // END,
+    '2',  // COST2,
+    '3',  // COST3,
+    '4',  // COST4,
+    '5',  // COST5,
+    '6',  // COST6,
+    '7',  // COST7,
+    '8',  // COST8,
+    '9',  // COST9,
+};
+
+// cost of entering a tile of each type in weighted searches; plain
+// BFS treats every tile that is not a WALL as costing 1
+int tile_costs[TILETYPE_COUNT] = {
+    0,  // NOTSET = 0,
+    0,  // WALL, never entered
+    1,  // OPEN,
+    1,  // ONPATH,
+    1,  // START,
+    1,  // END,
+    2,  // COST2,
+    3,  // COST3,
+    4,  // COST4,
+    5,  // COST5,
+    6,  // COST6,
+    7,  // COST7,
+    8,  // COST8,
+    9,  // COST9,
 };
 
 // characters to print in the visual rendering of the BFS in the maze
@@ -62,66 +99,72 @@ char digit10_chars[] = "0abcdefghijklmnopqrstuvwxyzABCDE%GHIJKLMNOPQR$TUVWXYZ";
 
 // Allocates a new queue structure in heap memory and initializes it as empty.
 rcqueue_t *rcqueue_allocate() {
+  return rcqueue_allocate_capacity(RCQUEUE_MIN_CAPACITY);
+}
+
+// Allocates an empty queue with room for at least `capacity`
+// coordinates before it needs to grow. The capacity is rounded up to
+// a power of 2 so positions wrap around with a mask.
+rcqueue_t *rcqueue_allocate_capacity(int capacity) {
   rcqueue_t *one = malloc(sizeof(rcqueue_t));  // Allocate memory for the queue
 
-  one->front = NULL;  // Initialize front pointer to NULL (empty queue)
-  one->rear = NULL;   // Initialize rear pointer to NULL (empty queue)
-  one->count = 0;     // Initialize node count to 0
+  one->capacity = RCQUEUE_MIN_CAPACITY;
+  while (one->capacity < capacity) {
+    one->capacity *= 2;
+  }
+  one->slots = malloc(sizeof(rcnode_t) * one->capacity);
+  one->front = 0;  // Empty queue starts at slot 0
+  one->count = 0;  // Initialize count to 0
 
   return one;  // Return the allocated queue
 }
 
-// Adds a new node with given row and column values to the end of the queue.
-void rcqueue_add_rear(rcqueue_t *queue, int row, int col) {
-  rcnode_t *new = malloc(sizeof(rcnode_t));  // Allocate memory for the new node
-
-  new->row = row;    // Assign row value
-  new->col = col;    // Assign column value
-  new->next = NULL;  // Set next pointer to NULL (new node is last in queue)
+// Doubles the slots of a full queue, unwrapping its contents so they
+// start at slot 0 of the new array.
+static void rcqueue_grow(rcqueue_t *queue) {
+  rcnode_t *slots = malloc(sizeof(rcnode_t) * queue->capacity * 2);
+  int first = queue->capacity - queue->front;  // slots from front to the end of the array
+  memcpy(slots, queue->slots + queue->front, sizeof(rcnode_t) * first);
+  memcpy(slots + first, queue->slots, sizeof(rcnode_t) * queue->front);
+  free(queue->slots);
+  queue->slots = slots;
+  queue->front = 0;
+  queue->capacity *= 2;
+}
 
-  if (queue->front == NULL) {  // If the queue is empty
-    queue->front = new;        // Set both front and rear to the new node
-    queue->rear = new;
-  } else {
-    queue->rear->next = new;  // Link the current rear node to the new node
-    queue->rear = new;        // Update rear to the new node
+// Adds the given row and column values to the end of the queue.
+void rcqueue_add_rear(rcqueue_t *queue, int row, int col) {
+  if (queue->count == queue->capacity) {  // Make room if every slot is in use
+    rcqueue_grow(queue);
   }
-  queue->count++;  // Increase node count
+  int rear = (queue->front + queue->count) & (queue->capacity - 1);  // Slot just past the last coordinate
+  queue->slots[rear].row = row;  // Assign row value
+  queue->slots[rear].col = col;  // Assign column value
+  queue->count++;                // Increase count
 }
 
-// Frees all memory associated with the queue and its nodes.
+// Frees all memory associated with the queue.
 void rcqueue_free(rcqueue_t *queue) {
-  while (queue->count > 0) {            // Loop until the queue is empty
-    rcnode_t *temp = queue->front;      // Store current front node
-    queue->front = queue->front->next;  // Move front to next node
-    free(temp);                         // Free the previous front node
-    queue->count--;                     // Decrease node count
-  }
-  free(queue);  // Free the queue struct itself
+  free(queue->slots);  // Free the slot array
+  free(queue);         // Free the queue struct itself
 }
 
 // Retrieves the front element's row and column values without modifying the queue.
 int rcqueue_get_front(rcqueue_t *queue, int *rowp, int *colp) {
-  if (queue->count > 0) {       // Check if the queue is not empty
-    *rowp = queue->front->row;  // Retrieve row value
-    *colp = queue->front->col;  // Retrieve column value
-    return 1;                   // Return success
+  if (queue->count > 0) {                     // Check if the queue is not empty
+    *rowp = queue->slots[queue->front].row;  // Retrieve row value
+    *colp = queue->slots[queue->front].col;  // Retrieve column value
+    return 1;                                // Return success
   }
   return 0;  // Return failure if queue is empty
 }
 
-// Removes the front node of the queue and frees its memory.
+// Removes the front coordinate of the queue.
 int rcqueue_remove_front(rcqueue_t *queue) {
-  if (queue->count > 0) {               // Check if the queue is not empty
-    rcnode_t *temp = queue->front;      // Store the current front node
-    queue->front = queue->front->next;  // Move front pointer to the next node
-    free(temp);                         // Free the removed node
-    queue->count--;                     // Decrease node count
-
-    if (queue->front == NULL) {  // If queue becomes empty after removal
-      queue->rear = NULL;        // Set rear pointer to NULL as well
-    }
-    return 1;  // Return success
+  if (queue->count > 0) {                                          // Check if the queue is not empty
+    queue->front = (queue->front + 1) & (queue->capacity - 1);  // Advance front, wrapping around
+    queue->count--;                                                // Decrease count
+    return 1;                                                      // Return success
   }
   return 0;  // Return failure if queue is empty
 }
@@ -132,10 +175,9 @@ void rcqueue_print(rcqueue_t *queue) {
     printf("queue count: %d\n", queue->count);  // Print number of nodes
     printf("NN ROW COL\n");                     // Print header
 
-    rcnode_t *temp = queue->front;                     // Start from the front of the queue
-    for (int i = 0; i < queue->count; i++) {           // Iterate through the queue
-      printf("%2d%3d%3d\n", i, temp->row, temp->col);  // Print node index, row, and col
-      temp = temp->next;                               // Move to the next node
+    for (int i = 0; i < queue->count; i++) {  // Iterate through the queue from its front slot
+      rcnode_t *slot = &queue->slots[(queue->front + i) & (queue->capacity - 1)];
+      printf("%2d%3d%3d\n", i, slot->row, slot->col);  // Print position, row, and col
     }
   } else {
     printf("null queue\n");  // Print message if queue is NULL
@@ -148,26 +190,31 @@ void rcqueue_print(rcqueue_t *queue) {
 
 // Prints the path for a given tile based on the selected format (compact or verbose)
 void tile_print_path(tile_t *tile, int format) {
+  tile_fprint_path(tile, format, stdout);
+}
+
+// Prints the path of `tile` like tile_print_path() but to `out`
+void tile_fprint_path(tile_t *tile, int format, FILE *out) {
   // If the path is NULL, print that no path was found
   if (tile->path == NULL) {
-    printf("No path found\n");
+    fprintf(out, "No path found\n");
   } else {
     // If the format is compact, print the path in compact form without newlines
     if (format == 1) {
       for (int i = 0; i < tile->path_len; i++) {
-        printf("%s", direction_compact_strs[tile->path[i]]);
+        fputs(direction_compact_strs[tile->path[i]], out);
       }
     }
     // If the format is verbose, print the length of the path and each step with its index
     else if (format == 2) {
-      printf("path length: %d\n", tile->path_len);
+      fprintf(out, "path length: %d\n", tile->path_len);
       for (int i = 0; i < tile->path_len; i++) {
-        printf(" %d: %s\n", i, direction_verbose_strs[tile->path[i]]);
+        fprintf(out, " %d: %s\n", i, direction_verbose_strs[tile->path[i]]);
       }
     }
     // If an unsupported format is given, print an error message
     else {
-      printf("Not tested, error format\n");
+      fprintf(out, "Not tested, error format\n");
     }
   }
 }
@@ -247,14 +294,28 @@ void tile_extend_path(tile_t *src, tile_t *dst, direction_t dir) {
 // dst is now   {.path_len = 5,  .path = {NORTH, EAST, EAST, SOUTH, EAST} };
 //
 // NOTES: This function will need to access fields of the
-// tiles. Review syntax to do so.
-
-// Allocates a maze of given rows and columns and initializes the tiles
+// tiles. Review syntax to do so. BFS no longer copies paths per tile;
+// it records predecessor directions and maze_tile_path() rebuilds a
+// path on demand, so this is only a utility for building paths.
+
+// Allocates a maze of given rows and columns and initializes the
+// tiles. Returns NULL after printing an error if the size is negative,
+// its grid would have more than MAZE_MAX_CELLS cells or it cannot be
+// allocated.
 maze_t *maze_allocate(int rows, int cols) {
+  if (rows < 0 || cols < 0 || ((long) rows + 2) * ((long) cols + 2) > MAZE_MAX_CELLS) {
+    maze_load_error("ERROR: a maze of %d rows and %d cols is not supported\n", rows, cols);
+    return NULL;
+  }
   maze_t *one = malloc(sizeof(maze_t));  // Allocate memory for the maze struct
+  if (one == NULL) {
+    maze_load_error("ERROR: out of memory for a maze of %d rows and %d cols\n", rows, cols);
+    return NULL;
+  }
 
   one->rows = rows;
   one->cols = cols;
+  one->stride = cols + 2;  // one sentinel column on each side
 
   // Initialize start/end coordinates and queue as NULL
   one->start_row = -1;
@@ -262,57 +323,62 @@ maze_t *maze_allocate(int rows, int cols) {
   one->start_col = -1;
   one->end_col = -1;
   one->queue = NULL;
+  one->expanded = 0;
+  one->path_cost = -1;
+  one->component = NULL;  // only labelled if reachability checks are requested
+  one->component_count = 0;
+  one->log_level = LOG_LEVEL;
+  one->pred = NULL;  // allocated when a BFS starts
+  one->dist = NULL;  // only allocated if distances are requested
+  one->solution.path = NULL;
+  one->solution.path_len = -1;
+
+  // One contiguous grid of tile types; interior tiles start as NOTSET (0)
+  long cells = MAZE_CELLS(one);
+  one->grid = calloc(cells, sizeof(unsigned char));
+  one->found = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  if (one->grid == NULL || one->found == NULL) {
+    maze_load_error("ERROR: out of memory for a maze of %d rows and %d cols\n", rows, cols);
+    free(one->grid);
+    free(one->found);
+    free(one);
+    return NULL;
+  }
 
-  // Allocate memory for a 2D array of tiles
-  one->tiles = malloc(sizeof(tile_t) * rows * cols);
-
-  // Initialize each tile with default values (NOTSET for type, 1 for state, NULL for path, -1 for path_len)
-  for (int i = 0; i < one->rows; i++) {
-    one->tiles[i] = malloc(sizeof(tile_t) * cols);
-    for (int j = 0; j < one->cols; j++) {
-      one->tiles[i][j].type = NOTSET;
-      one->tiles[i][j].state = 1;
-      one->tiles[i][j].path = NULL;
-      one->tiles[i][j].path_len = -1;
-    }
+  // Surround the tiles with WALL sentinels so neighbors never need bounds checks
+  memset(one->grid, WALL, one->stride);                           // top border row
+  memset(one->grid + (long)(rows + 1) * one->stride, WALL, one->stride);  // bottom border row
+  for (int i = 0; i < rows; i++) {
+    MAZE_TYPE(one, i, -1) = WALL;    // left border column
+    MAZE_TYPE(one, i, cols) = WALL;  // right border column
   }
 
   return one;  // Return the allocated maze
 }
 // PROBLEM 2: Allocate on the heap a maze with the given rows/cols.
-// Allocates space for the maze struct itself and an array of row
-// pointers for its tiles. Then uses a nested set of loops to allocate
-// each row of tiles for the maze and initialize the fields of each
-// tile to be NOTSET, NOTFOUND, NULL, and -1 appropriately. Sets
+// Allocates space for the maze struct itself and a single row-major
+// grid of (rows+2)*(cols+2) one-byte tile types. Interior tiles start
+// as NOTSET and the outer ring is filled with WALL sentinels so that
+// any neighbor of an in-bounds tile can be read without bounds
+// checks. A separate bitset tracks which tiles are FOUND during BFS;
+// predecessor directions are only allocated once a BFS starts. Sets
 // start/end row/col fields to be -1 and the queue to be NULL
 // initially. Returns the resulting maze.
 //
-// CONSTRAINT: Assumes malloc() succeeds and does not include checks
-// for its failure. Does not bother with checking rows/cols for
-// inappropriate values such as 0 or negatives.
-//
-// NOTES: Consult recent lab work for examples of how to allocate a 2D
-// array using repeated malloc() calls and adapt that approach
-// hear. Ensure that the allocation is being done via rows of tile_t
-// structs. Common errors are to neglect initializing all fields of
-// the maze and all fields of every tile.  Valgrind errors that data
-// is uninitialized are usually resolved by adding code to explicitly
-// initialize everything.
+// CONSTRAINT: Returns NULL after printing an error through
+// maze_load_error() if rows or cols is negative, the grid would have
+// more than MAZE_MAX_CELLS cells or the allocations fail; callers must
+// check for it.
 
 // Frees the memory associated with the maze and its tiles
 void maze_free(maze_t *maze) {
-  // Free each tile's path if it exists and then free the row of tiles
-  for (int i = 0; i < maze->rows; i++) {
-    for (int j = 0; j < maze->cols; j++) {
-      if (maze->tiles[i][j].path != NULL) {
-        free(maze->tiles[i][j].path);  // Free the path if it's not NULL
-        maze->tiles[i][j].path = NULL;
-      }
-    }
-    free(maze->tiles[i]);  // Free each row of tiles
-  }
+  free(maze->pred);           // Free BFS predecessors and distances; free(NULL) is a no-op
+  free(maze->dist);
+  free(maze->component);
+  free(maze->solution.path);  // Free the rebuilt solution path
 
-  free(maze->tiles);  // Free the array of rows
+  free(maze->grid);   // Free the tile grid
+  free(maze->found);  // Free the FOUND bitset
 
   // If the maze has a queue, free it as well
   if (maze->queue != NULL) {
@@ -322,53 +388,78 @@ void maze_free(maze_t *maze) {
   free(maze);  // Finally, free the maze struct itself
 }
 // PROBLEM 2: De-allocates the memory associated with a maze and its
-// tiles.  Uses a doubly nested loop to iterate over all tiles and
-// de-allocate any non-NULL paths that are part of the tiles.
-// Iterates to free each row of the tiles row and frees then frees the
-// array of row tile row pointers. If the queue is non-null, frees it
-// and finally frees the maze struct itself.
+// tiles. Frees the BFS predecessor/distance arrays and the solution
+// path if present, then the tile grid and FOUND bitset. If the queue
+// is non-null, frees it and finally frees the maze struct itself.
 
-// Returns 1 if a tile at given coordinates is blocked (out of bounds or a wall), otherwise returns 0
+// Returns 1 if a tile at given coordinates is blocked (border or a wall), otherwise returns 0
 int maze_tile_blocked(maze_t *maze, int row, int col) {
-  // Check if the tile is out of bounds or if it's a wall
-  if (maze->tiles == NULL || row < 0 || col < 0 || row >= maze->rows || col >= maze->cols ||
-      maze->tiles[row][col].type == WALL) {
-    return 1;  // The tile is blocked
-  }
-  return 0;  // The tile is not blocked
+  // Border sentinels are WALL so a single type check covers out of bounds
+  return MAZE_TYPE(maze, row, col) == WALL;
 }
 
 // PROBLEM 2: Return 1 if the indicated coordinate is blocked and
 // could not be traversed as part of a path solving a maze. A
-// coordinate is blocked if it is out of bounds for the maze (row/col
-// below zero or above maze row/col boundaries) or the tile at that
+// coordinate is blocked if it is on the border just outside the maze
+// (row/col of -1 or equal to the maze rows/cols) or the tile at that
 // coordinate has type WALL. If the coordinate is not blocked, returns
 // 0.  This function will be used later during the
 // Breadth-First-Search to determine if a coordinate should be ignored
 // due to being blocked.
 //
-// NOTES: This function will require accessing fields of the maze so
-// review syntax on struct field acces and 2D indexing into the maze's
-// tiles table. The tiletype_t enumeration in mazesolve.h establishes
-// global symbols for tile types like OPEN, ONPATH, START, and so
-// forth. Use one of these in this function.
-
-// Prints the maze and its tiles, showing the start and end points
-void maze_print_tiles(maze_t *maze) {
-  // Print the maze size and start/end coordinates
-  printf("maze: %d rows %d cols\n", maze->rows, maze->cols);
-  printf("      (%d,%d) start\n", maze->start_row, maze->start_col);
-  printf("      (%d,%d) end\n", maze->end_row, maze->end_col);
+// NOTES: The border of the grid holds WALL sentinels so no bounds
+// checks are made; coordinates must be at most one tile outside the
+// maze, which is always the case for neighbors of in-bounds tiles.
+
+// Returns the distance from Start of the FOUND tile at grid index
+// `idx`, using the tracked distance if available and otherwise
+// counting predecessor steps back to the Start tile.
+int maze_pred_distance(maze_t *maze, int idx) {
+  if (maze->dist != NULL) {
+    return maze->dist[idx];
+  }
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int len = 0;
+  while (idx != start) {
+    direction_t d = PRED_GET(maze->pred, idx);
+    idx -= DIR_OFFSET(maze, d);  // step back against the incoming direction
+    len++;
+  }
+  return len;
+}
 
-  printf("maze tiles:\n");
+// Rebuilds the path from Start to the tile at row/col by walking its
+// predecessor directions back to Start. Any path already in `tile` is
+// freed. Returns 1 and fills in the path/path_len of `tile` if the
+// tile was FOUND. Otherwise returns 0 and leaves the path NULL with
+// path_len -1.
+int maze_tile_path(maze_t *maze, int row, int col, tile_t *tile) {
+  free(tile->path);
+  tile->path = NULL;
+  tile->path_len = -1;
+
+  int idx = MAZE_INDEX(maze, row, col);
+  if (maze->pred == NULL || !BITSET_GET(maze->found, idx)) {
+    return 0;
+  }
 
-  // Print each tile character based on its type (from the tiletype_chars[] array)
-  for (int i = 0; i < maze->rows; i++) {
-    for (int j = 0; j < maze->cols; j++) {
-      printf("%c", tiletype_chars[maze->tiles[i][j].type]);
-    }
-    printf("\n");
+  // Fill the path from its last step backwards; always allocate at
+  // least one element so the Start tile gets a non-NULL empty path
+  int len = maze_pred_distance(maze, idx);
+  tile->path = malloc(sizeof(direction_t) * (len + 1));
+  tile->path_len = len;
+  for (int i = len - 1; i >= 0; i--) {
+    direction_t d = PRED_GET(maze->pred, idx);
+    tile->path[i] = d;
+    idx -= DIR_OFFSET(maze, d);
   }
+  return 1;
+}
+
+// Prints the maze and its tiles, showing the start and end points;
+// formatted in bulk by mazesolve_render.c within PRINT_VIEW
+void maze_print_tiles(maze_t *maze) {
+  maze_render_tiles(maze, &PRINT_VIEW, stdout);
 }
 // PROBLEM 2: Prints `maze` showing the solution path from Start to
 // End tiles. First prints maze information including the size in rows
@@ -414,41 +505,9 @@ void maze_print_tiles(maze_t *maze) {
 
 // Prints the maze state, showing the progress of the BFS search and the tile states
 void maze_print_state(maze_t *maze) {
-  // Iterate through each tile to print its state or path length
-  for (int i = 0; i < maze->rows; i++) {
-    for (int j = 0; j < maze->cols; j++) {
-      // If the tile has been found, print its path length as a character
-      if (maze->tiles[i][j].state == FOUND) {
-        if (maze->tiles[i][j].path_len % 10 == 0) {
-          printf("%c", digit10_chars[maze->tiles[i][j].path_len / 10]);  // Print character for multiples of 10
-        } else {
-          printf("%d", maze->tiles[i][j].path_len % 10);  // Print last digit of path length
-        }
-      }
-      // If the tile is not found, print its type (e.g., wall or open space)
-      else {
-        printf("%c", tiletype_chars[maze->tiles[i][j].type]);
-      }
-    }
-    printf(": %d\n", i);  // Print the row number
-  }
-
-  // Print the column axis labels (0, 1, 2, ..., n)
-  int loop = 0;
-  int cols_num = maze->cols;
-  for (int i = 0; i < cols_num; i++) {
-    printf("%d", i);
-    if (i == 9) {  // After 9, reset and print the tens
-      i = -1;
-      cols_num -= 10;
-      loop++;
-    }
-  }
-  printf("\n0");
-  for (int i = 1; i < loop + 1; i++) {
-    printf("%9d", i);  // Print the tens row
-  }
-  printf("\n");
+  // Tiles with their distances, row labels and the column ruler are
+  // formatted in bulk by mazesolve_render.c within PRINT_VIEW
+  maze_render_state(maze, &PRINT_VIEW, stdout);
 
   // Print the maze queue
   rcqueue_print(maze->queue);
@@ -526,283 +585,76 @@ void maze_print_state(maze_t *maze) {
 // FUNCTIONS FOR PROBLEM 3: Breadth First Search of the Maze
 ////////////////////////////////////////////////////////////////////////////////
 
-void maze_bfs_init(maze_t *maze) {
-  // Initialize the start tile for BFS.
-  maze->tiles[maze->start_row][maze->start_col].path = malloc(0);  // Empty path initially.
-  maze->tiles[maze->start_row][maze->start_col].path_len = 0;      // Start tile has no path length yet.
-  maze->tiles[maze->start_row][maze->start_col].state = FOUND;     // Mark the start tile as FOUND.
-
-  // Initialize the queue for BFS.
-  maze->queue = rcqueue_allocate();                                 // Allocate the queue.
-  rcqueue_add_rear(maze->queue, maze->start_row, maze->start_col);  // Add the start tile to the queue.
-
-  // Log the initialization process if appropriate.
-  if (LOG_LEVEL >= LOG_BFS_STATES) {
-    printf("LOG: BFS initialization complete\n");
-    maze_print_state(maze);  // Print the maze state after initialization.
-  }
+// Initial queue capacity for searching `maze`. A BFS frontier is a
+// band of tiles equidistant from Start so it is usually proportional
+// to the maze perimeter rather than its area; the queue grows in the
+// rare cases where this is too small.
+int maze_queue_capacity(maze_t *maze) {
+  return 4 * (maze->rows + maze->cols);
 }
-// PROBLEM 3: Initializes the maze for a BFS search. Adjusts the start
-// tile: allocates it a length 0 path, sets its path_len to 0, and
-// sets its state to FOUND. Allocates an empty rcqueue for the queue
-// in the maze using an appropriate function and then adds the Start
-// tile to it.
-//
-// LOGGING: If LOG_LEVEL >= LOG_BFS_STATES, after initialization is
-// complete. prints "BFS initialization compelte" and calls
-// maze_print_state().
-//
-// NOTES: This function is called within maze_bfs_iterate() to set up
-// the queue and Start tile before the search proceeds. It should not
-// be called outside of that context except during some testing of its
-// functionality and that of the BFS step function.
-//
-// EXAMPLE: The queue is initially empty (prints as null). After
-//          calling bfs_init(), the Start tile is set to FOUND so
-//          prints as its path_len of 0 and appears in the now
-//          allocated queue.
-//
-// print_maze_state(maze);
-//   ################:  0
-//   #S             #:  1
-//   # ### ###### # #:  2
-//   # ### ##E  #   #:  3
-//   # ### #### ##  #:  4
-//   #              #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   null queue
-// LOG_LEVEL = LOG_ALL;
-// maze_bfs_init(maze);
-// print_maze_state(maze);
-//   LOG: BFS initialization complete
-//   ################:  0
-//   #0             #:  1
-//   # ### ###### # #:  2
-//   # ### ##E  #   #:  3
-//   # ### #### ##  #:  4
-//   #              #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 1
-//   NN ROW COL
-//    0   1   1
-
-int maze_bfs_process_neighbor(maze_t *maze, int cur_row, int cur_col, direction_t dir) {
-  tile_t *cur = &maze->tiles[cur_row][cur_col];  // Current tile in the BFS.
-  int new_row, new_col;
-
-  // Compute the coordinates of the neighboring tile based on the direction.
-  new_row = cur_row + row_delta[dir];
-  new_col = cur_col + col_delta[dir];
-
-  // If the neighboring tile is blocked, skip it.
-  if (maze_tile_blocked(maze, new_row, new_col) == 1 && LOG_LEVEL >= LOG_SKIPPED_TILES) {
-    printf("LOG: Skipping BLOCKED tile at (%d,%d) \n", new_row, new_col);
-    return 0;  // Return 0 as the tile is blocked and cannot be processed.
-  }
 
-  tile_t *new_one = &maze->tiles[new_row][new_col];  // Neighbor tile.
-
-  // If the neighboring tile has already been found, skip it.
-  if (new_one->state == FOUND && LOG_LEVEL >= LOG_SKIPPED_TILES) {
-    printf("LOG: Skipping FOUND tile at (%d,%d)\n", new_row, new_col);
-    return 0;  // Return 0 as the tile has already been processed.
+// Requests that the BFS record the distance from Start of every FOUND
+// tile in maze->dist. Without it, distances are recovered on demand by
+// walking predecessors which is fine for printing small mazes.
+void maze_bfs_track_distance(maze_t *maze) {
+  if (maze->dist == NULL) {
+    maze->dist = malloc(sizeof(int) * MAZE_CELLS(maze));
   }
+}
 
-  // If the neighboring tile is not found, process it.
-  if (new_one->state != FOUND && LOG_LEVEL >= LOG_BFS_PATHS) {
-    new_one->state = FOUND;                           // Mark the neighbor tile as FOUND.
-    tile_extend_path(cur, new_one, dir);              // Extend the path from the current tile to the neighbor.
-    rcqueue_add_rear(maze->queue, new_row, new_col);  // Add the neighbor to the queue.
-
-    // Log the newly found tile and its path if appropriate.
-    printf("LOG: Found tile at (%d,%d) with len %d path: ", new_row, new_col, new_one->path_len);
-    tile_print_path(new_one, PATH_FORMAT_COMPACT);  // Print the compact path of the tile.
-    printf("\n");
-
-    return 1;  // Return 1 as the neighbor was successfully processed.
+// Resets the search state shared by all engines: allocates cleared
+// predecessor storage, forgets tiles FOUND by any earlier search and
+// marks the Start tile FOUND at distance 0.
+void maze_search_reset(maze_t *maze) {
+  // Allocate predecessor storage for all tiles now that a search is
+  // starting and forget tiles FOUND by any earlier search.
+  free(maze->pred);
+  maze->pred = calloc(PRED_BYTES(MAZE_CELLS(maze)), sizeof(unsigned char));
+  memset(maze->found, 0, sizeof(uint64_t) * BITSET_WORDS(MAZE_CELLS(maze)));
+  maze->expanded = 0;
+
+  // Initialize the start tile; it is the only FOUND tile with no predecessor.
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  BITSET_SET(maze->found, start);  // Mark the start tile as FOUND.
+  if (maze->dist != NULL) {
+    maze->dist[start] = 0;         // Start tile has distance 0.
   }
-
-  return 0;  // Return 0 as no changes were made.
 }
-// PROBLEM 3: Process the neighbor in direction `dir` from coordinates
-// `cur_row/cur_col`. Calculates the adjacent tiles row/col
-// coordinates using the row_delta[]/col_delta[] global array and
-// `dir`.  If the neighbor tile is blocked according to the
-// maze_tile_blocked() function, makes no changes and returns 0 as the
-// position cannot be reached. If the neighbor tile has state FOUND,
-// makes no changes and returns 0 as the tile has already been
-// processed in the BFS. Otherwise changes the neighbor tile to be a
-// Found tile: extends the current tile's path to the neighbor tile in
-// the given direction, changes the neighbor tile's state to FOUND,
-// and adds the neighbor tile to the maze search queue. This function
-// is used in BFS to propogate paths to all non-blocked neighbor
-// tiles and extend the search forntier.
-//
-// LOGGING:
-// 1. If LOG_LEVEL >= LOG_BFS_PATHS and the neighor tile's state
-//    changes from NOTFOUND to FOUND, print a message like:
-//      LOG: Found tile at (4,10) with len 14 path: SSSSEEEEEEEEEN
-//    with the coordinates, path_len, and COMPACT path for the newly
-//    found tile.
-// 2. If LOG_LEVEL >= LOG_SKIPPED_TILES and the neighbor tile is
-//    skipped as it is blocked or already found, print a message like
-//    one of
-//      LOG: Skipping BLOCKED tile at (6,13)
-//      LOG: Skipping FOUND tile at (5,12)
-//
-// EXAMPLE:
-// maze_print_state(maze);
-//   ################:  0
-//   #0123          #:  1
-//   #1### ###### # #:  2
-//   #2### ##E  #   #:  3
-//   #3### #### ##  #:  4
-//   #4             #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 2
-//   NN ROW COL
-//    0   1   4
-//    1   5   1
-// LOG_LEVEL = LOG_ALL; // above both LOG_BFS_PATHS and LOG_SKIPPED_TILES
-// maze_bfs_process_neighbor(maze, 1, 4, NORTH);
-//   LOG: Skipping BLOCKED tile at (0,4)
-// maze_bfs_process_neighbor(maze, 1, 4, SOUTH);
-//   LOG: Skipping BLOCKED tile at (2,4)
-// maze_bfs_process_neighbor(maze, 1, 4, WEST);
-//   LOG: Skipping FOUND tile at (1,3)
-// maze_bfs_process_neighbor(maze, 1, 4, EAST);
-//   LOG: Found tile at (1,5) with len 4 path: EEEE
-// maze_print_state(maze);
-//   ################:  0
-//   #01234         #:  1
-//   #1### ###### # #:  2
-//   #2### ##E  #   #:  3
-//   #3### #### ##  #:  4
-//   #4             #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 2
-//   NN ROW COL
-//    0   1   4
-//    1   5   1
-//    2   1   5
-
-int maze_bfs_step(maze_t *maze) {
-  if (maze == NULL) {
-    printf("maze is NULL");
-    return 0;  // Return 0 if the maze pointer is NULL.
-  }
-
-  int row, col;
-  rcqueue_get_front(maze->queue, &row, &col);  // Get the coordinates of the front tile in the queue.
-
-  // Log the processing of neighbors for the front tile if appropriate.
-  if (LOG_LEVEL >= LOG_BFS_STEPS) {
-    printf("LOG: processing neighbors of (%d,%d)\n", row, col);
-
-    // Process all neighbors in the four directions (North, South, West, East).
-    for (int i = 1; i < 5; i++) {
-      maze_bfs_process_neighbor(maze, row, col, dir_delta[i]);  // Process the neighbor in direction `i`.
-    }
-    rcqueue_remove_front(maze->queue);  // Remove the front tile from the queue.
 
-    // Log the maze state after processing the step if appropriate.
-    if (LOG_LEVEL >= LOG_BFS_STATES) {
-      printf("LOG: maze state after BFS step\n");
-      maze_print_state(maze);  // Print the maze state.
-    }
-    return 1;  // Return 1 as the step was successfully processed.
+// The BFS init, neighbor, step and search loop are expanded from
+// mazesolve_bfs.h twice: instrumented with logging under the public
+// names and as a production kernel with all logging compiled out.
+#define BFS_NAME(name) name
+#define BFS_LINKAGE
+#define BFS_LOG(level) (maze->log_level >= (level))
+#include "mazesolve_bfs.h"
+#undef BFS_NAME
+#undef BFS_LINKAGE
+#undef BFS_LOG
+
+#define BFS_NAME(name) name##_production
+#define BFS_LINKAGE static
+#define BFS_LOG(level) 0
+#include "mazesolve_bfs.h"
+#undef BFS_NAME
+#undef BFS_LINKAGE
+#undef BFS_LOG
+
+// Runs a BFS from the Start tile. If `stop_at_end` is nonzero the
+// search stops as soon as the End tile is FOUND, otherwise it floods
+// every reachable tile. The number of tiles expanded is left in
+// maze->expanded. Returns 1 if the End tile was FOUND and 0 otherwise.
+// The instrumented kernel runs if BFS_INSTRUMENTED is nonzero and the
+// production kernel otherwise; both give identical results.
+int maze_bfs_search(maze_t *maze, int stop_at_end) {
+  if (BFS_INSTRUMENTED) {
+    return maze_bfs_run(maze, stop_at_end);
   }
-
-  return 0;  // Return 0 if the logging level does not require detailed steps.
+  return maze_bfs_run_production(maze, stop_at_end);
 }
-// PROBLEM 3: Processes the tile in BFS which is at the front of the
-// maze search queue. For the front tile, iterates over the directions
-// in the global dir_delta[] array from index DELTA_START to less than
-// DELTA_COUNT which will be NORTH, SOUTH, WEST, EAST. Processes the
-// neighbors in each of these directions with an appropriate
-// function. Removes the front element of the search queue and
-// returns 1. Note: if this function is called when the maze queue is
-// empty, return 0 and print an error message though this case will
-// not be tested and should not arise if other parts of the program
-// are correct.
-//
-// LOGGING:
-// If LOG_LEVEL >= LOG_BFS_STEPS, print a message like
-//   LOG: processing neighbors of (5,1)
-// at the start of the function.
-//
-// If LOG_LEVEL >= LOG_BFS_STATES, prints a message and uses
-// maze_print_state() at the end of the function to show the maze
-// after processing finishes as in:
-//   LOG: maze state after BFS step
-//   ################:  0
-//   #01234         #:  1
-//   #1### ###### # #:  2
-//   #2### ##E  #   #:  3
-//   #3### #### ##  #:  4
-//   #45            #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 2
-//   NN ROW COL
-//    0   1   5
-//    1   5   2
-//
-// EXAMPLE:
-// maze_print_state(maze);
-//   ################:  0
-//   #0123456789a1  #:  1
-//   #1###5###### # #:  2
-//   #2###6##E  #   #:  3
-//   #3###7#### ##  #:  4
-//   #456789a12     #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 2
-//   NN ROW COL
-//    0   1  12
-//    1   5   9
-// LOG_LEVEL = LOG_ALL;
-// maze_bfs_step(maze);
-//   LOG: processing neighbors of (1,12)
-//   LOG: maze state after BFS step
-//   ################:  0
-//   #0123456789a12 #:  1
-//   #1###5######2# #:  2
-//   #2###6##E  #   #:  3
-//   #3###7#### ##  #:  4
-//   #456789a12     #:  5
-//   ################:  6
-//   0123456789012345
-//   0         1
-//   queue count: 3
-//   NN ROW COL
-//    0   5   9
-//    1   2  12
-//    2   1  13
 
 void maze_bfs_iterate(maze_t *maze) {
-  maze_bfs_init(maze);  // Initialize the BFS search on the maze.
-  int step = 1;         // Initialize the step counter.
-
-  // Continue iterating until the queue is empty.
-  while (maze->queue->count != 0) {
-    if (LOG_LEVEL >= LOG_BFS_STEPS) {
-      printf("LOG: BFS STEP %d\n", step);  // Log the current step.
-    }
-    maze_bfs_step(maze);  // Process one step of the BFS.
-    step++;               // Increment the step counter.
-  }
+  maze_bfs_search(maze, 0);  // Flood the whole maze.
 }
 // PROBLEM 3: Initializes a BFS on the maze and iterates BFS steps
 // until the queue for the maze is empty and the BFS is complete. Each
@@ -820,48 +672,66 @@ void maze_bfs_iterate(maze_t *maze) {
 // NOTES: This function will call several of the preceding functions
 // to initialize and proceed with the BFS.
 
+// Runs a BFS that stops as soon as the End tile is FOUND rather than
+// flooding the whole maze. Paths to tiles that were FOUND are still
+// shortest paths so maze_set_solution() works as after a full
+// flood. Returns 1 if the End tile was reached and leaves the number
+// of expanded tiles in maze->expanded.
+int maze_bfs_solve(maze_t *maze) {
+  return maze_bfs_search(maze, 1);
+}
+
+// BFS flooding every tile reachable from Start.
+int maze_bfs_flood(maze_t *maze) {
+  return maze_bfs_search(maze, 0);
+}
+
+// Returns the solution path rebuilt by maze_set_solution(); its path is
+// NULL if there is no solution or it has not been set yet.
+tile_t *maze_end_tile(maze_t *maze) {
+  return &maze->solution;
+}
+
 int maze_set_solution(maze_t *maze) {
-  tile_t *end = &maze->tiles[maze->end_row][maze->end_col];  // End tile.
+  tile_t *end = &maze->solution;  // Path to the End tile.
 
-  if (end->path == NULL) {
+  // Rebuild the Start to End path by walking predecessors back from End.
+  if (!maze_tile_path(maze, maze->end_row, maze->end_col, end)) {
     return 0;  // Return 0 if the end tile has no path (no solution found).
   }
 
-  // Log the solution path if appropriate.
-  if (LOG_LEVEL >= LOG_SET_SOLUTION) {
+  if (maze->log_level >= LOG_SET_SOLUTION) {
     printf("LOG: solution START at (%d,%d)\n", maze->start_row, maze->start_col);
+  }
 
-    // Set the path starting from the start tile and moving towards the end tile.
-    int new_row = maze->start_row + row_delta[end->path[0]];
-    int new_col = maze->start_col + col_delta[end->path[0]];
-    maze->tiles[new_row][new_col].type = ONPATH;  // Mark the first tile in the path.
-    printf("LOG: solution path[%d] is %s, set (%d,%d) to ONPATH\n", 0, direction_verbose_strs[end->path[0]], new_row,
-           new_col);
-
-    // Continue setting the path for the remaining tiles.
-    for (int i = 1; i < end->path_len; i++) {
-      new_row += row_delta[end->path[i]];
-      new_col += col_delta[end->path[i]];
+  // Set the path starting from the start tile and moving towards the end tile.
+  int new_row = maze->start_row;
+  int new_col = maze->start_col;
+  for (int i = 0; i < end->path_len; i++) {
+    new_row += row_delta[end->path[i]];
+    new_col += col_delta[end->path[i]];
 
-      maze->tiles[new_row][new_col].type = ONPATH;  // Mark each tile in the path.
+    MAZE_TYPE(maze, new_row, new_col) = ONPATH;  // Mark each tile in the path.
 
+    if (maze->log_level >= LOG_SET_SOLUTION) {
       printf("LOG: solution path[%d] is %s, set (%d,%d) to ONPATH\n", i, direction_verbose_strs[end->path[i]], new_row,
              new_col);
     }
+  }
 
-    // Log the end of the solution path.
+  // Log the end of the solution path.
+  if (maze->log_level >= LOG_SET_SOLUTION) {
     printf("LOG: solution END at (%d,%d)\n", maze->end_row, maze->end_col);
-    end->type = END;  // Mark the end tile as END.
-
-    return 1;  // Return 1 to indicate the solution was set successfully.
   }
+  MAZE_TYPE(maze, maze->end_row, maze->end_col) = END;  // Mark the end tile as END.
 
-  return 0;  // Return 0 if the solution was not set.
+  return 1;  // Return 1 to indicate the solution was set successfully.
 }
-// PROBLEM 3: Uses the path stored in the End tile to visit each tile
-// on the solution path from Star to End and make them as ONPATH to
-// show the solution path.  If the End tile has a NULL path, returns 0
-// and makes no changes to the maze. Otherwise, visits each direction
+// PROBLEM 3: Rebuilds the path to the End tile from the predecessor
+// directions left by BFS into maze->solution then uses it to visit
+// each tile on the solution path from Star to End and make them as
+// ONPATH to show the solution path.  If the End tile was not FOUND,
+// returns 0 and makes no changes to the maze. Otherwise, visits each direction
 // in the End tile's path and, beginning at the Start tile, "moves" in
 // the direction indicated and chcnges the nextf tile's state to
 // ONPATH. Returns 1 on changing the state of tiles to show the
@@ -949,70 +819,124 @@ int maze_set_solution(maze_t *maze) {
 // FUNCTIONS FOR PROBLEM 4: Maze Memory Allocation and File Input
 ////////////////////////////////////////////////////////////////////////////////
 
+// Prints an error found loading a maze like printf() to LOAD_ERRORS.
+void maze_load_error(char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(LOAD_ERRORS != NULL ? LOAD_ERRORS : stdout, fmt, args);
+  va_end(args);
+}
+
 maze_t *maze_from_file(char *fname) {
+  return maze_read_file(fname, LOG_LEVEL);
+}
+
+// Reads the "rows: R cols: C" and "tiles:" lines of a text maze from
+// `handle` into `rows`/`cols`, leaving it at the first tile. Only the
+// newline after "tiles:" is consumed so leading OPEN tiles of the
+// first row stay. Returns 1 if a size of at least one row and col was
+// read and 0 otherwise, as for the mapped and binary loaders.
+int maze_read_header(FILE *handle, int *rows, int *cols) {
+  int found = fscanf(handle, "rows: %d cols: %d\n", rows, cols) == 2 && *rows > 0 && *cols > 0;
+  fscanf(handle, "tiles:%*[\r]");
+  fgetc(handle);
+  return found;
+}
+
+// Reads a maze like maze_from_file() but logs by `log_level` rather
+// than LOG_LEVEL, which is also kept as the log level of the maze so
+// threads can load and search mazes with their own logging.
+maze_t *maze_read_file(char *fname, int log_level) {
+  // Binary mazes are recognized by their magic number (see mazesolve_binary.c)
+  if (maze_binary_detect(fname)) {
+    mazebin_t *bin = maze_binary_open(fname);
+    if (bin == NULL) {
+      return NULL;
+    }
+    maze_t *maze = maze_from_binary(bin, log_level);
+    maze_binary_close(bin);
+    return maze;  // NULL if it could not be allocated
+  }
+
+  // Without per-tile logging text mazes are mapped and classified in
+  // bulk (see mazesolve_load.c); the fscanf() loader below logs
+  if (LOAD_MAPPED && log_level < LOG_FILE_LOAD) {
+    return maze_load_mapped(fname, log_level);
+  }
+
   FILE *handle = fopen(fname, "r");  // open the file
 
   // if the file can't be openeed, print error message and return NULL
   if (handle == NULL) {
-    printf("ERROR: could not open file %s\n", fname);
+    maze_load_error("ERROR: could not open file %s\n", fname);
     return NULL;
   }
   int rows, cols;  // to hold the number of rows and cols of maze read from file
 
-  fscanf(handle, "rows: %d cols: %d\n", &rows, &cols);  // read in the rows and cols #s from file
-  fscanf(handle, "tiles:\n");                           // read in the "tiles" lines
-  maze_t *one = maze_allocate(rows, cols);              // using the read rows and cols, create new maze
+  // read in the rows and cols #s and the "tiles" line, then create a maze of that size
+  if (!maze_read_header(handle, &rows, &cols)) {
+    maze_load_error("ERROR: could not read the size of maze %s\n", fname);
+    fclose(handle);
+    return NULL;
+  }
+  maze_t *one = maze_allocate(rows, cols);
+  if (one == NULL) {
+    fclose(handle);
+    return NULL;
+  }
+  one->log_level = log_level;
 
-  if (LOG_LEVEL >= LOG_FILE_LOAD) {
+  if (one->log_level >= LOG_FILE_LOAD) {
     printf("LOG: expecting %d rows and %d columns\n", rows, cols);  // print the number of rows and cols
     printf("LOG: beginning to read tiles\n");                       // print the message to read the tile
   }
 
   char c = ' ';  // to hold the value for the tiles
 
-  // I can't get to the finished reading row to print correct row, so I am using this
-  int i = 0;               // set i to zero
-  int printed_rows = i--;  // set the correct reading row to print
-
   // Read the maze tiles from the file row by row
   for (int i = 0; i < rows; i++) {
     for (int j = 0; j < cols; j++) {
       // Read a character for the tile (it could be a space, wall, or a special character)
-      fscanf(handle, "%c", &c);
-      // Skip the newline character, but don't increment printed_rows here)
-      if (c == '\n' && LOG_LEVEL >= LOG_FILE_LOAD) {
-        printf("LOG: finished reading row %d of tiles\n", printed_rows++);
-        j--;       // return col to zero
-        continue;  // proceed to the next row
+      if (fscanf(handle, "%c", &c) != 1) {
+        break;  // file ended early; leave remaining tiles NOTSET
+      }
+      // Skip the newline ending the previous row without using up a column
+      if (c == '\n') {
+        j--;
+        continue;
       }
 
-      // Loop over all possible tile types (assuming there are 6 types)
-      for (int z = 0; z < 6; z++) {    // six types, traverse through all
+      // Loop over all tile types to find the one displayed as this character
+      for (int z = 0; z < TILETYPE_COUNT; z++) {
         if (c == tiletype_chars[z]) {  // Check if the character matches one of the tile types
-
-          one->tiles[i][j].type = z;  // Set the tile type in the maze
-          // If logging level allows, log details about this tile
-          if (LOG_LEVEL >= LOG_FILE_LOAD) {
+          MAZE_TYPE(one, i, j) = z;    // Set the tile type in the maze
+          if (one->log_level >= LOG_FILE_LOAD) {
             printf("LOG: (%d,%d) has character '%c' type %d\n", i, j, c, z);
-            // Special case: if the tile is the start point (type 4)
-            if (z == 4) {
+          }
+          // Special case: record the position of the start tile
+          if (z == START) {
+            if (one->log_level >= LOG_FILE_LOAD) {
               printf("LOG: setting START at (%d,%d)\n", i, j);
-              one->start_row = i;
-              one->start_col = j;
             }
-            // Special case: if the tile is the end point (type 5)
-            if (z == 5) {
+            one->start_row = i;
+            one->start_col = j;
+          }
+          // Special case: record the position of the end tile
+          if (z == END) {
+            if (one->log_level >= LOG_FILE_LOAD) {
               printf("LOG: setting END at (%d,%d)\n", i, j);
-              one->end_row = i;
-              one->end_col = j;
             }
+            one->end_row = i;
+            one->end_col = j;
           }
         }
       }
     }
+    // After finishing each row, log the progress if the logging level is sufficient
+    if (one->log_level >= LOG_FILE_LOAD) {
+      printf("LOG: finished reading row %d of tiles\n", i);
+    }
   }
-  // After finishing each row, log the progress if the logging level is sufficient
-  printf("LOG: finished reading row %d of tiles\n", rows - 1);
 
   // Close the file and return the populated maze structure
   fclose(handle);
@@ -1108,6 +1032,46 @@ maze_t *maze_from_file(char *fname) {
 //  argument. The 2nd form sets the global variable LOG_LEVEL to the
 //  value N which enables additional output.
 //
+//  Further options may precede the maze file: -flood searches the
+//  whole maze instead of stopping once End is found (implied when
+//  logging BFS steps; only bfs, parallel, hybrid, dial and multi can
+//  flood), -stats prints the number of tiles expanded, -engine NAME
+//  picks a search engine from mazesolve_engines.c, -threads N sets
+//  the threads used by the parallel engine and -sources FILE prints
+//  the distance to End from each "row col" tile listed in FILE. -serve
+//  and -socket PATH keep the maze loaded and answer path queries from
+//  stdin or a Unix socket, caching up to
+//  -cache-mb N megabytes of BFS results (see mazesolve_server.c).
+//  -alt-build FILE writes -landmarks K landmark distance tables to
+//  FILE and -alt FILE maps them for the alt engine. -edits FILE applies
+//  batches of tile edits, repairing the flood after each one and timing
+//  the repair against a full BFS (see mazesolve_repair.c). -external DIR
+//  solves mazes larger than memory from bands of rows kept in DIR with
+//  at most -mem-mb N megabytes resident (see mazesolve_extern.c).
+//  -kernel instrumented|production picks the BFS kernel; by default
+//  the instrumented one runs only when -log is given. -view ROW COL
+//  ROWS COLS prints only that window of the maze, from ROW,COL down
+//  and right; a size of -1 extends it to the edge (see
+//  mazesolve_render.c). -batch makes the last argument a directory or
+//  a file listing mazes, which are solved by -workers N threads with
+//  their solutions printed in order or written to -out DIR (see
+//  mazesolve_batch.c). The maze file may be text or binary, told apart
+//  by its first bytes; -to-binary FILE and -to-text FILE convert it to
+//  the other format instead of solving (see mazesolve_binary.c).
+//  -load-threads N sets the threads parsing a large text maze, by
+//  default one per online CPU (see mazesolve_load.c). Tiles written
+//  as digits 2-9 are terrain costing that much to enter; -engine dial
+//  finds the cheapest path over them and prints its "path cost" after
+//  the path, while the other engines count each tile as one step (see
+//  mazesolve_dial.c). A maze may hold several S and E tiles; -engine
+//  multi searches from all Starts at once, solves the closest
+//  Start/End pair and names it after the path. With -flood it also
+//  labels every tile with its nearest Start and reports the nearest
+//  Start of each End (see mazesolve_multi.c). -components labels the
+//  connected components of the maze after loading so a Start and End
+//  in different ones, or a server query between them, are answered as
+//  unreachable without searching (see mazesolve_components.c).
+//
 //  NOTES
 //  - It is a good idea to check that the number of command line arguments
 //    is either 2 (Form 1) and 4 (Form 2) and if not, bail out from the
@@ -0,0 +1,227 @@
+// mazesolve_gen.c: deterministic maze generators writing the maze file format
+#include "mazesolve.h"
+
+// Each style writes a maze to a stream one row at a time, keeping only
+// a few rows of state, so mazes far larger than memory can be written.
+// Mazes depend only on the style, size and seed: the random numbers
+// come from a splitmix64 generator rather than rand() so the same seed
+// gives the same maze on every platform.
+//
+//   perfect     spanning-tree maze by the Sidewinder algorithm, one path
+//               between any two open tiles
+//   rooms       open rooms joined by doors in a spanning tree with
+//               extra doors that make loops
+//   random      each tile a WALL with a given density
+//   serpentine  one corridor winding down the maze, paths of rows*cols/2
+
+#define GEN_ROOM 8              // rows/cols inside a room of the rooms style
+#define GEN_EXTRA_DOOR 4        // the rooms style adds a loop door with chance 1 in GEN_EXTRA_DOOR
+
+// Returns the next number of the splitmix64 sequence in *state.
+static uint64_t gen_next(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Returns a random number in [0,n).
+static long gen_below(uint64_t *state, long n) {
+  return (long) ((gen_next(state) >> 11) % (uint64_t) n);
+}
+
+// Writes a row of `cols` tiles and its newline to `out`.
+static void gen_write_row(FILE *out, char *row, int cols) {
+  row[cols] = '\n';
+  fwrite(row, 1, cols + 1, out);
+}
+
+// Perfect maze: tiles at even row/col are cells, the tiles between
+// them passages or WALL. Sidewinder carves each row of cells from the
+// row above: runs of cells are joined eastward and each run opens one
+// passage north, so a row only depends on the one before it.
+static void gen_perfect(FILE *out, int rows, int cols, uint64_t *rng, double density) {
+  int cell_rows = (rows + 1) / 2, cell_cols = (cols + 1) / 2;
+  char *row = malloc(cols + 1);
+  char *north = malloc(cell_cols);  // 1 where a cell of this row opens north
+  char *east = malloc(cell_cols);   // 1 where a cell of this row opens east
+  for (int k = 0; k < cell_rows; k++) {
+    memset(north, 0, cell_cols);
+    memset(east, 0, cell_cols);
+    int run_start = 0;
+    for (int j = 0; j < cell_cols; j++) {
+      if (j < cell_cols - 1 && (k == 0 || gen_below(rng, 2))) {
+        east[j] = 1;  // the top row has nothing north so it is one run
+      } else if (k > 0) {
+        north[run_start + gen_below(rng, j - run_start + 1)] = 1;
+        run_start = j + 1;
+      }
+    }
+    if (k > 0) {
+      for (int c = 0; c < cols; c++) {
+        row[c] = c % 2 == 0 && north[c / 2] ? tiletype_chars[OPEN] : tiletype_chars[WALL];
+      }
+      gen_write_row(out, row, cols);
+    }
+    for (int c = 0; c < cols; c++) {
+      row[c] = c % 2 == 0 || east[c / 2] ? tiletype_chars[OPEN] : tiletype_chars[WALL];
+    }
+    if (k == 0) {
+      row[0] = tiletype_chars[START];
+    }
+    if (k == cell_rows - 1) {
+      row[2 * (cell_cols - 1)] = tiletype_chars[END];
+    }
+    gen_write_row(out, row, cols);
+  }
+  if (rows % 2 == 0) {
+    memset(row, tiletype_chars[WALL], cols);  // an even row count ends below the last cells
+    gen_write_row(out, row, cols);
+  }
+  free(row);
+  free(north);
+  free(east);
+}
+
+// Rooms: GEN_ROOM square rooms separated by single WALL lines. Doors
+// between rooms follow Sidewinder over the grid of rooms so all rooms
+// are connected, and extra doors are added at random to make loops.
+static void gen_rooms(FILE *out, int rows, int cols, uint64_t *rng, double density) {
+  int period = GEN_ROOM + 1;
+  int room_rows = (rows + period - 1) / period, room_cols = (cols + period - 1) / period;
+  char *row = malloc(cols + 1);
+  int *north = malloc(sizeof(int) * room_cols);  // column of the door north of each room, -1 if none
+  int *east = malloc(sizeof(int) * room_cols);   // row offset of the door east of each room, -1 if none
+  for (int i = 0; i < room_rows; i++) {
+    int height = rows - i * period < GEN_ROOM ? rows - i * period : GEN_ROOM;
+    int run_start = 0;
+    for (int j = 0; j < room_cols; j++) {
+      north[j] = east[j] = -1;
+      if (j < room_cols - 1 && (i == 0 || gen_below(rng, 2))) {
+        east[j] = gen_below(rng, height);
+      } else if (i > 0) {
+        int door = run_start + gen_below(rng, j - run_start + 1);
+        int width = cols - door * period < GEN_ROOM ? cols - door * period : GEN_ROOM;
+        north[door] = door * period + gen_below(rng, width);
+        run_start = j + 1;
+      }
+    }
+
+    // Extra doors join rooms already connected and so make loops
+    for (int j = 0; i > 0 && j < room_cols; j++) {
+      int width = cols - j * period < GEN_ROOM ? cols - j * period : GEN_ROOM;
+      if (north[j] < 0 && gen_below(rng, GEN_EXTRA_DOOR) == 0) {
+        north[j] = j * period + gen_below(rng, width);
+      }
+      if (j < room_cols - 1 && east[j] < 0 && gen_below(rng, GEN_EXTRA_DOOR) == 0) {
+        east[j] = gen_below(rng, height);
+      }
+    }
+
+    if (i > 0) {
+      memset(row, tiletype_chars[WALL], cols);
+      for (int j = 0; j < room_cols; j++) {
+        if (north[j] >= 0) {
+          row[north[j]] = tiletype_chars[OPEN];
+        }
+      }
+      gen_write_row(out, row, cols);
+    }
+    for (int r = 0; r < height; r++) {
+      for (int c = 0; c < cols; c++) {
+        int j = c / period;
+        row[c] = c % period < GEN_ROOM || east[j] == r ? tiletype_chars[OPEN] : tiletype_chars[WALL];
+      }
+      if (i == 0 && r == 0) {
+        row[0] = tiletype_chars[START];
+      }
+      if (i == room_rows - 1 && r == height - 1) {
+        int last = (room_cols - 1) * period;
+        row[cols - last < GEN_ROOM ? cols - 1 : last + GEN_ROOM - 1] = tiletype_chars[END];
+      }
+      gen_write_row(out, row, cols);
+    }
+    if (i == room_rows - 1 && height == GEN_ROOM && rows % period == 0) {
+      memset(row, tiletype_chars[WALL], cols);  // the size ends on a WALL line
+      gen_write_row(out, row, cols);
+    }
+  }
+  free(row);
+  free(north);
+  free(east);
+}
+
+// Random: every tile other than Start at the top left and End at the
+// bottom right is a WALL with chance `density`; there may be no path.
+static void gen_random(FILE *out, int rows, int cols, uint64_t *rng, double density) {
+  char *row = malloc(cols + 1);
+  uint64_t threshold = density >= 1.0 ? UINT64_MAX : (uint64_t) (density * 18446744073709551616.0);
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < cols; c++) {
+      row[c] = gen_next(rng) < threshold ? tiletype_chars[WALL] : tiletype_chars[OPEN];
+    }
+    if (r == 0) {
+      row[0] = tiletype_chars[START];
+    }
+    if (r == rows - 1) {
+      row[cols - 1] = tiletype_chars[END];
+    }
+    gen_write_row(out, row, cols);
+  }
+  free(row);
+}
+
+// Serpentine: open even rows joined by one gap at alternating ends of
+// the WALL odd rows, giving about the longest shortest path a maze of
+// its size can have.
+static void gen_serpentine(FILE *out, int rows, int cols, uint64_t *rng, double density) {
+  char *row = malloc(cols + 1);
+  int last = rows % 2 == 1 ? rows - 1 : rows - 2;  // last open row
+  for (int r = 0; r < rows; r++) {
+    if (r % 2 == 0) {
+      memset(row, tiletype_chars[OPEN], cols);
+      if (r == 0) {
+        row[0] = tiletype_chars[START];
+      }
+      if (r == last) {
+        row[(r / 2) % 2 == 0 ? cols - 1 : 0] = tiletype_chars[END];
+      }
+    } else {
+      memset(row, tiletype_chars[WALL], cols);
+      if (r < last) {
+        row[(r / 2) % 2 == 0 ? cols - 1 : 0] = tiletype_chars[OPEN];
+      }
+    }
+    gen_write_row(out, row, cols);
+  }
+  free(row);
+}
+
+maze_style_t maze_styles[] = {
+  {"perfect",    gen_perfect},    // Sidewinder spanning tree, unique paths
+  {"rooms",      gen_rooms},      // open rooms joined by doors, with loops
+  {"random",     gen_random},     // independent WALL tiles with the given density
+  {"serpentine", gen_serpentine}, // one winding corridor
+  {NULL,         NULL},
+};
+
+// Returns the style named `name` or NULL if there is none.
+maze_style_t *maze_style_lookup(char *name) {
+  for (int i = 0; maze_styles[i].name != NULL; i++) {
+    if (strcmp(maze_styles[i].name, name) == 0) {
+      return &maze_styles[i];
+    }
+  }
+  return NULL;
+}
+
+// Writes a `rows` by `cols` maze of `style` generated from `seed` to
+// `out` in the format read by maze_from_file(). `density` is the
+// chance of a WALL tile for the random style and ignored by the
+// others. `rows` and `cols` must be positive.
+void maze_generate(FILE *out, maze_style_t *style, int rows, int cols, uint64_t seed, double density) {
+  uint64_t rng = seed;
+  fprintf(out, "rows: %d cols: %d\n", rows, cols);
+  fprintf(out, "tiles:\n");
+  style->generate(out, rows, cols, &rng, density);
+}
@@ -0,0 +1,175 @@
+// mazesolve_hybrid.c: direction-optimizing BFS switching between top-down and bottom-up layers
+#include "mazesolve.h"
+
+// A level-synchronous BFS can find the next layer two ways:
+//
+// - top-down: each frontier tile pushes out to its unFOUND neighbors,
+//   as maze_bfs_process_neighbor() does; the work is proportional to
+//   the frontier.
+// - bottom-up: each unFOUND open tile looks for a neighbor in the
+//   frontier; the work is proportional to the tiles not yet FOUND.
+//
+// In narrow corridors the frontier is a few tiles and top-down wins by
+// far, but when the search spills into a large open area the frontier
+// can cover a good fraction of what is left and bottom-up is cheaper.
+// As in Beamer et al. this switches to bottom-up once the frontier
+// exceeds 1/HYBRID_ALPHA of the unFOUND open tiles. It switches back
+// once the frontier drops below 1/HYBRID_BETA of the unFOUND tiles
+// rather than of all tiles: a maze frontier is always small next to
+// the whole maze so the latter would flip back on the next layer.
+#define HYBRID_ALPHA 14
+#define HYBRID_BETA  24
+
+typedef struct {                // state of one direction-optimizing BFS
+  maze_t *maze;                 // maze being searched, FOUND bits mark visited tiles
+  uint64_t *open;               // bitset of non-WALL tiles, indexed like grid
+  uint64_t *front;              // bitset of the current layer
+  uint64_t *next;               // bitset of the layer being built
+  int *layer;                   // current layer as grid indices
+  int *next_layer;              // layer being built as grid indices
+  long count;                   // number of tiles in layer
+  long next_count;              // number of tiles in next_layer
+} hybrid_t;
+
+// Marks tile `idx` FOUND, reached from its neighbor `from` by a step
+// in direction `dir`, and adds it to the next layer.
+static void hybrid_found(hybrid_t *h, int idx, int from, direction_t dir) {
+  maze_t *maze = h->maze;
+  BITSET_SET(maze->found, idx);
+  PRED_SET(maze->pred, idx, dir);
+  if (maze->dist != NULL) {
+    maze->dist[idx] = maze->dist[from] + 1;
+  }
+  BITSET_SET(h->next, idx);
+  h->next_layer[h->next_count++] = idx;
+}
+
+// Top-down layer: each frontier tile claims its open unFOUND
+// neighbors in dir_delta[] order. Returns the number of tiles expanded.
+static long hybrid_top_down(hybrid_t *h) {
+  maze_t *maze = h->maze;
+  for (long f = 0; f < h->count; f++) {
+    int cur = h->layer[f];
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      int n = cur + DIR_OFFSET(maze, dir);
+      if (maze->grid[n] != WALL && !BITSET_GET(maze->found, n)) {
+        hybrid_found(h, n, cur, dir);
+      }
+    }
+  }
+  return h->count;
+}
+
+// Bottom-up layer: each open unFOUND tile, in grid order, takes the
+// first neighbor in the frontier as its predecessor. Returns the
+// number of tiles examined.
+static long hybrid_bottom_up(hybrid_t *h) {
+  maze_t *maze = h->maze;
+  long examined = 0;
+  long words = BITSET_WORDS(MAZE_CELLS(maze));
+  for (long w = 0; w < words; w++) {
+    uint64_t todo = h->open[w] & ~maze->found[w];
+    while (todo != 0) {
+      int idx = w * 64 + __builtin_ctzll(todo);
+      todo &= todo - 1;
+      examined++;
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        direction_t dir = dir_delta[i];
+        int from = idx - DIR_OFFSET(maze, dir);  // neighbor that steps `dir` into idx
+        if (BITSET_GET(h->front, from)) {
+          hybrid_found(h, idx, from, dir);
+          break;
+        }
+      }
+    }
+  }
+  return examined;
+}
+
+// Searches from Start choosing top-down or bottom-up for each layer
+// from the frontier size. If `stop_at_end` is nonzero the search stops
+// after the layer that FOUND the End tile, otherwise it floods every
+// reachable tile. Paths to FOUND tiles are shortest paths though ties
+// may be broken differently than maze_bfs_search(). Logs the mode of
+// each layer at LOG_BFS_STEPS. Returns 1 if the End tile was FOUND and
+// leaves the number of tiles expanded or examined in maze->expanded.
+int maze_hybrid_search(maze_t *maze, int stop_at_end) {
+  maze->expanded = 0;
+  if (maze->start_row < 0) {
+    return 0;  // Nothing to search from without a Start tile.
+  }
+  maze_search_reset(maze);
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = maze->end_row >= 0 ? MAZE_INDEX(maze, maze->end_row, maze->end_col) : -1;
+
+  hybrid_t h;
+  long cells = MAZE_CELLS(maze);
+  long words = BITSET_WORDS(cells);
+  h.maze = maze;
+  h.open = calloc(words, sizeof(uint64_t));
+  h.front = calloc(words, sizeof(uint64_t));
+  h.next = calloc(words, sizeof(uint64_t));
+  h.layer = malloc(sizeof(int) * cells);
+  h.next_layer = malloc(sizeof(int) * cells);
+  long open_count = 0;
+  for (long i = 0; i < cells; i++) {
+    if (maze->grid[i] != WALL) {
+      BITSET_SET(h.open, i);
+      open_count++;
+    }
+  }
+  long unfound = open_count - 1;  // open tiles not yet FOUND
+  h.layer[0] = start;
+  h.count = 1;
+  BITSET_SET(h.front, start);
+
+  int bottom_up = 0;
+  int depth = 0;
+  while (h.count > 0 && !(stop_at_end && end >= 0 && BITSET_GET(maze->found, end))) {
+    // Switch modes on the frontier size relative to what is left
+    if (!bottom_up && h.count * HYBRID_ALPHA > unfound) {
+      bottom_up = 1;
+    } else if (bottom_up && h.count * HYBRID_BETA < unfound) {
+      bottom_up = 0;
+    }
+    if (maze->log_level >= LOG_BFS_STEPS) {
+      printf("LOG: BFS layer %d %s with %ld frontier tiles\n",
+             depth, bottom_up ? "bottom-up" : "top-down", h.count);
+    }
+
+    h.next_count = 0;
+    maze->expanded += bottom_up ? hybrid_bottom_up(&h) : hybrid_top_down(&h);
+    unfound -= h.next_count;
+
+    // Clear the old frontier and make the new layer the frontier
+    for (long f = 0; f < h.count; f++) {
+      h.front[h.layer[f] >> 6] = 0;
+    }
+    uint64_t *tmp_bits = h.front;
+    h.front = h.next;
+    h.next = tmp_bits;
+    int *tmp_layer = h.layer;
+    h.layer = h.next_layer;
+    h.next_layer = tmp_layer;
+    h.count = h.next_count;
+    depth++;
+  }
+
+  free(h.open);
+  free(h.front);
+  free(h.next);
+  free(h.layer);
+  free(h.next_layer);
+  return end >= 0 && BITSET_GET(maze->found, end);
+}
+
+// Direction-optimizing BFS that stops once the End tile is FOUND.
+int maze_hybrid_solve(maze_t *maze) {
+  return maze_hybrid_search(maze, 1);
+}
+
+// Direction-optimizing BFS flooding every tile reachable from Start.
+int maze_hybrid_flood(maze_t *maze) {
+  return maze_hybrid_search(maze, 0);
+}
@@ -0,0 +1,184 @@
+// mazesolve_jps.c: Jump Point Search for 4-connected mazes
+#include "mazesolve.h"
+
+// Jump Point Search runs A* over a small set of "jump points" instead
+// of every tile. It relies on a canonical ordering of shortest paths:
+// among equally short paths, prefer the one that moves vertically
+// before horizontally. Under that ordering
+//
+// - a tile entered vertically may continue vertically or turn WEST
+//   or EAST;
+// - a tile entered horizontally may only continue horizontally unless
+//   a perpendicular neighbor is "forced": the neighbor is open but
+//   the tile beside it, one step back, is blocked, so the
+//   vertical-first path around it does not exist.
+//
+// Jumps scan along a row or column without queueing anything and stop
+// only at End, at a tile with a forced neighbor, or (for vertical
+// jumps) at a tile from which a horizontal jump would stop. In open
+// rooms this replaces thousands of queued tiles with a handful of jump
+// points.
+
+// Heap key preferring smaller f then smaller h, as in mazesolve_astar.c
+#define JPS_KEY(f,h) ((((uint64_t) (f)) << 32) | (uint32_t) (h))
+
+// 1 if tile `x`, entered by a horizontal step of `step`, has a forced
+// neighbor on the side `side` (+/- stride).
+#define JPS_FORCED(maze,x,step,side) \
+  ((maze)->grid[(x)+(side)] != WALL && (maze)->grid[(x)-(step)+(side)] == WALL)
+
+// Scans horizontally from `x` by `step` (+1 or -1). Returns the grid
+// index of the first jump point or -1 if a wall is hit first.
+static int jps_jump_horizontal(maze_t *maze, int x, int step, int goal) {
+  while (1) {
+    x += step;
+    if (maze->grid[x] == WALL) {
+      return -1;
+    }
+    if (x == goal || JPS_FORCED(maze, x, step, -maze->stride) || JPS_FORCED(maze, x, step, +maze->stride)) {
+      return x;
+    }
+  }
+}
+
+// Scans vertically from `x` by `step` (+/- stride). Every tile passed
+// may turn horizontally so the scan stops at the first tile from which
+// a horizontal jump finds a jump point. Returns the grid index of the
+// jump point or -1 if a wall is hit first.
+static int jps_jump_vertical(maze_t *maze, int x, int step, int goal) {
+  while (1) {
+    x += step;
+    if (maze->grid[x] == WALL) {
+      return -1;
+    }
+    if (x == goal || jps_jump_horizontal(maze, x, -1, goal) >= 0 || jps_jump_horizontal(maze, x, +1, goal) >= 0) {
+      return x;
+    }
+  }
+}
+
+// Manhattan distance from grid index `idx` to the End tile
+static int jps_heuristic(maze_t *maze, int idx) {
+  int row = idx / maze->stride - 1;
+  int col = idx % maze->stride - 1;
+  return abs(row - maze->end_row) + abs(col - maze->end_col);
+}
+
+// Searches from Start to End with Jump Point Search. Jump points are
+// kept in a heap keyed like maze_astar_search(); each records its
+// distance, the jump point it was reached from and, in the maze
+// predecessors, the direction of the straight segment that reached
+// it. Once End is expanded, the segments back to Start are walked and
+// every tile on them is marked FOUND with its incoming direction so
+// maze_set_solution() rebuilds the usual tile-by-tile path. Returns 1
+// if End is reachable and leaves the number of jump points expanded in
+// maze->expanded.
+int maze_jps_solve(maze_t *maze) {
+  maze->expanded = 0;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return 0;  // need both Start and End to search between them
+  }
+  maze_search_reset(maze);
+
+  long cells = MAZE_CELLS(maze);
+  int *g = malloc(sizeof(int) * cells);          // distance of each seen jump point
+  int *parent = malloc(sizeof(int) * cells);     // jump point each one was reached from
+  uint64_t *seen = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  uint64_t *closed = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  tileheap_t *open = tileheap_allocate(maze_queue_capacity(maze));
+
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = MAZE_INDEX(maze, maze->end_row, maze->end_col);
+  int h = jps_heuristic(maze, start);
+  g[start] = 0;
+  parent[start] = start;
+  BITSET_SET(seen, start);
+  tileheap_push(open, JPS_KEY(h, h), start);
+
+  int solved = 0;
+  heapnode_t node;
+  while (tileheap_pop(open, &node)) {
+    int cur = node.idx;
+    if (BITSET_GET(closed, cur)) {
+      continue;  // stale entry for a jump point expanded with a shorter distance
+    }
+    BITSET_SET(closed, cur);
+    maze->expanded++;
+    if (cur == end) {
+      solved = 1;
+      break;
+    }
+
+    // Pick the directions allowed by the canonical ordering
+    int allowed[DELTA_COUNT] = {0};
+    if (cur == start) {
+      allowed[NORTH] = allowed[SOUTH] = allowed[WEST] = allowed[EAST] = 1;
+    } else {
+      direction_t in = PRED_GET(maze->pred, cur);
+      int step = DIR_OFFSET(maze, in);
+      allowed[in] = 1;
+      if (row_delta[in] != 0) {  // entered vertically: may turn either way
+        allowed[WEST] = allowed[EAST] = 1;
+      } else {                   // entered horizontally: turn only towards forced neighbors
+        allowed[NORTH] = JPS_FORCED(maze, cur, step, -maze->stride);
+        allowed[SOUTH] = JPS_FORCED(maze, cur, step, +maze->stride);
+      }
+    }
+
+    // Jump in each allowed direction and relax the jump point found
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      if (!allowed[dir]) {
+        continue;
+      }
+      int step = DIR_OFFSET(maze, dir);
+      int jump = row_delta[dir] != 0 ? jps_jump_vertical(maze, cur, step, end)
+                                     : jps_jump_horizontal(maze, cur, step, end);
+      if (jump < 0 || BITSET_GET(closed, jump)) {
+        continue;
+      }
+      int jump_g = g[cur] + abs(jump - cur) / abs(step);  // straight segment length
+      if (BITSET_GET(seen, jump) && g[jump] <= jump_g) {
+        continue;  // already reached at least as cheaply
+      }
+      BITSET_SET(seen, jump);
+      g[jump] = jump_g;
+      parent[jump] = cur;
+      PRED_SET(maze->pred, jump, dir);
+      h = jps_heuristic(maze, jump);
+      tileheap_push(open, JPS_KEY(jump_g + h, h), jump);
+    }
+  }
+
+  // Expand the chain of segments from End back to Start into per-tile
+  // predecessors; only tiles on the solution are marked FOUND so every
+  // FOUND tile has a complete predecessor chain.
+  if (solved) {
+    int idx = end;
+    int d = g[end];
+    while (idx != start) {
+      int from = parent[idx];
+      direction_t dir = PRED_GET(maze->pred, idx);
+      for (int x = idx; x != from; x -= DIR_OFFSET(maze, dir)) {
+        BITSET_SET(maze->found, x);
+        PRED_SET(maze->pred, x, dir);
+        if (maze->dist != NULL) {
+          maze->dist[x] = d;
+        }
+        d--;
+      }
+      idx = from;
+    }
+  }
+
+  if (solved && maze->log_level >= LOG_BFS_STEPS) {
+    printf("LOG: jump point search expanded %ld jump points\n", maze->expanded);
+  }
+
+  free(g);
+  free(parent);
+  free(seen);
+  free(closed);
+  tileheap_free(open);
+  return solved;
+}
@@ -0,0 +1,339 @@
+// mazesolve_load.c: mmap()ed text maze loader classifying 32 tiles at a time
+#include "mazesolve.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(LOAD_NO_AVX2)
+#include <immintrin.h>
+#define LOAD_HAVE_AVX2 1        // AVX2 row classification compiled in, used if the CPU has it; -DLOAD_NO_AVX2 to leave out
+#endif
+
+int LOAD_MAPPED = 1;            // 1 to read text mazes with maze_load_mapped(), 0 for the fscanf() loader
+int LOAD_THREADS = 0;           // threads parsing a mapped maze, 0 for one per online CPU
+
+// The text loader of maze_read_file() reads one character per fscanf()
+// call and compares it with every entry of tiletype_chars[]. This
+// loader maps the file instead and handles one row at a time: a single
+// pass over the row compares 32 bytes at once against '\n' and each
+// tile character, writes the tile types straight into the grid and
+// notes Start and End from the same compares.
+//
+// A row of the file holding exactly `cols` tiles takes that path.
+// Otherwise the row is read a byte at a time skipping newlines, which
+// is how the fscanf() loader reads every row, so both loaders give the
+// same maze for any file: short rows continue on the next line, bytes
+// that are no tile character are NOTSET tiles and tiles missing at the
+// end of the file stay NOTSET.
+//
+// When every row is exactly `cols` tiles and a newline, as written by
+// the generators and converters, the file size gives it away and row i
+// starts at a known offset. The rows are then split into contiguous
+// ranges parsed by LOAD_THREADS threads at once. Each thread keeps the
+// last Start/End of its range and the last range holding one wins, as
+// in a serial read. A row breaking the layout makes the file be read
+// serially instead. Either way the maze is still loaded, but every line
+// of the first `rows` that does not hold exactly `cols` tiles, and a
+// file ending before `rows` lines, is reported with a warning.
+
+#define LOAD_NEWLINE 0xFF       // class of '\n' in the type table, ends the fast path
+#define LOAD_PARALLEL_MIN (1L << 20)  // fewest tiles in a maze parsed by more than one thread
+
+// Classifies one row of tiles, see load_row_scalar()
+typedef int (*loadrow_t)(unsigned char *src, int cols, unsigned char *dst, unsigned char *types,
+                         int *start_col, int *end_col);
+
+typedef struct {                // rows parsed by one thread of a parallel load
+  maze_t *maze;                 // maze whose grid is filled
+  unsigned char *data;          // mapped file
+  long size;                    // bytes in the file
+  long first;                   // offset of row 0
+  loadrow_t classify;           // row classifier
+  unsigned char *types;         // type table of the classifier
+  int lo, hi;                   // rows [lo,hi) parsed by this thread
+  int start_row, start_col;     // last Start in the rows, row -1 if none
+  int end_row, end_col;         // last End in the rows, row -1 if none
+  int bad_row;                  // first row breaking the layout, -1 if none
+  pthread_t tid;                // thread parsing the rows
+} loadpart_t;
+
+// Fills `types` with the tile type of every byte, the last match in
+// tiletype_chars[] winning as in the fscanf() loader.
+static void load_type_table(unsigned char *types) {
+  memset(types, NOTSET, 256);
+  for (int z = 0; z < TILETYPE_COUNT; z++) {
+    types[(unsigned char) tiletype_chars[z]] = z;
+  }
+  types['\n'] = LOAD_NEWLINE;
+}
+
+// Classifies the `cols` bytes at `src` into `dst` through `types`,
+// setting *start_col/*end_col to the last Start/End among them.
+// Returns 0 without finishing if a newline is among the bytes.
+static int load_row_scalar(unsigned char *src, int cols, unsigned char *dst, unsigned char *types,
+                           int *start_col, int *end_col) {
+  for (int c = 0; c < cols; c++) {
+    unsigned char t = types[src[c]];
+    if (t == LOAD_NEWLINE) {
+      return 0;
+    }
+    dst[c] = t;
+    if (t == START) {
+      *start_col = c;
+    } else if (t == END) {
+      *end_col = c;
+    }
+  }
+  return 1;
+}
+
+#ifdef LOAD_HAVE_AVX2
+// Same as load_row_scalar() but 32 bytes at a time: each tile
+// character is compared against the bytes and its type blended into
+// the result, so later characters win like the type table. Start and
+// End come from movemasks of the result.
+__attribute__((target("avx2")))
+static int load_row_avx2(unsigned char *src, int cols, unsigned char *dst, unsigned char *types,
+                         int *start_col, int *end_col) {
+  __m256i newline = _mm256_set1_epi8('\n');
+  __m256i start = _mm256_set1_epi8(START), end = _mm256_set1_epi8(END);
+  __m256i chars[TILETYPE_COUNT], type[TILETYPE_COUNT];
+  for (int z = 1; z < TILETYPE_COUNT; z++) {
+    chars[z] = _mm256_set1_epi8(tiletype_chars[z]);
+    type[z] = _mm256_set1_epi8(z);
+  }
+  int c = 0;
+  for (; c + 32 <= cols; c += 32) {
+    __m256i bytes = _mm256_loadu_si256((__m256i *) &src[c]);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline))) {
+      return 0;
+    }
+    __m256i out = _mm256_setzero_si256();  // NOTSET unless a character matches
+    for (int z = 1; z < TILETYPE_COUNT; z++) {
+      out = _mm256_blendv_epi8(out, type[z], _mm256_cmpeq_epi8(bytes, chars[z]));
+    }
+    _mm256_storeu_si256((__m256i *) &dst[c], out);
+    uint32_t s = _mm256_movemask_epi8(_mm256_cmpeq_epi8(out, start));
+    uint32_t e = _mm256_movemask_epi8(_mm256_cmpeq_epi8(out, end));
+    if (s) {
+      *start_col = c + 31 - __builtin_clz(s);
+    }
+    if (e) {
+      *end_col = c + 31 - __builtin_clz(e);
+    }
+  }
+  int s = -1, e = -1;  // Start/End in the tail, relative to it
+  if (!load_row_scalar(&src[c], cols - c, &dst[c], types, &s, &e)) {
+    return 0;
+  }
+  if (s >= 0) {
+    *start_col = c + s;
+  }
+  if (e >= 0) {
+    *end_col = c + e;
+  }
+  return 1;
+}
+#endif
+
+// Parses the rows of one range at their fixed offsets.
+static void *load_part_worker(void *arg) {
+  loadpart_t *part = arg;
+  maze_t *maze = part->maze;
+  int cols = maze->cols;
+  part->start_row = part->end_row = part->bad_row = -1;
+  for (int i = part->lo; i < part->hi; i++) {
+    long off = part->first + (long) i * (cols + 1);
+    int start_col = -1, end_col = -1;
+    if (!part->classify(&part->data[off], cols, &MAZE_TYPE(maze, i, 0), part->types, &start_col, &end_col) ||
+        (off + cols < part->size && part->data[off + cols] != '\n')) {
+      part->bad_row = i;
+      return NULL;
+    }
+    if (start_col >= 0) {
+      part->start_row = i;
+      part->start_col = start_col;
+    }
+    if (end_col >= 0) {
+      part->end_row = i;
+      part->end_col = end_col;
+    }
+  }
+  return NULL;
+}
+
+// Parses the rows of a file laid out as rows of `cols` tiles and a
+// newline from offset `first` on up to LOAD_THREADS threads. Returns
+// -1 once the grid, Start and End are filled in, or the first row that
+// breaks the layout.
+static int load_rows_parallel(maze_t *maze, unsigned char *data, long size, long first,
+                              loadrow_t classify, unsigned char *types) {
+  int threads = LOAD_THREADS > 0 ? LOAD_THREADS : sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > maze->rows) {
+    threads = maze->rows;
+  }
+  if (threads < 1 || (long) maze->rows * maze->cols < LOAD_PARALLEL_MIN) {
+    threads = 1;
+  }
+
+  // The calling thread parses the first range
+  loadpart_t *parts = malloc(sizeof(loadpart_t) * threads);
+  for (int t = 0; t < threads; t++) {
+    parts[t] = (loadpart_t) {
+      .maze = maze, .data = data, .size = size, .first = first, .classify = classify, .types = types,
+      .lo = (long) maze->rows * t / threads, .hi = (long) maze->rows * (t + 1) / threads,
+    };
+    if (t > 0) {
+      pthread_create(&parts[t].tid, NULL, load_part_worker, &parts[t]);
+    }
+  }
+  load_part_worker(&parts[0]);
+  for (int t = 1; t < threads; t++) {
+    pthread_join(parts[t].tid, NULL);
+  }
+
+  int bad_row = -1;
+  for (int t = 0; t < threads; t++) {
+    if (parts[t].bad_row >= 0 && bad_row < 0) {
+      bad_row = parts[t].bad_row;
+    }
+    if (parts[t].start_row >= 0) {
+      maze->start_row = parts[t].start_row;
+      maze->start_col = parts[t].start_col;
+    }
+    if (parts[t].end_row >= 0) {
+      maze->end_row = parts[t].end_row;
+      maze->end_col = parts[t].end_col;
+    }
+  }
+  free(parts);
+  return bad_row;
+}
+
+// Warns about every one of the `rows` lines from offset `p` that does
+// not hold exactly `cols` bytes, and if the file ends before them.
+static void load_check_rows(char *fname, unsigned char *data, long size, long p, int rows, int cols) {
+  for (int i = 0; i < rows; i++) {
+    if (p >= size) {
+      maze_load_error("WARNING: %s ends after %d of %d rows\n", fname, i, rows);
+      return;
+    }
+    unsigned char *nl = memchr(&data[p], '\n', size - p);
+    long len = nl != NULL ? nl - &data[p] : size - p;
+    if (len != cols) {
+      maze_load_error("WARNING: row %d of %s is %ld tiles, not %d\n", i, fname, len, cols);
+    }
+    p += len + 1;
+  }
+}
+
+// Parses the rows one after another from offset `p`, following
+// newlines wherever they are.
+static void load_rows_serial(maze_t *maze, unsigned char *data, long size, long p,
+                             loadrow_t classify, unsigned char *types) {
+  int cols = maze->cols;
+  maze->start_row = maze->start_col = maze->end_row = maze->end_col = -1;
+  for (int i = 0; i < maze->rows; i++) {
+    unsigned char *dst = &MAZE_TYPE(maze, i, 0);
+    while (p < size && data[p] == '\n') {
+      p++;  // the newline ending the previous row
+    }
+    int start_col = -1, end_col = -1;
+    if (size - p >= cols && classify(&data[p], cols, dst, types, &start_col, &end_col)) {
+      p += cols;
+    } else {
+      // A row broken by newlines or the end of the file
+      memset(dst, NOTSET, cols);
+      start_col = end_col = -1;
+      for (int j = 0; j < cols && p < size; p++) {
+        unsigned char t = types[data[p]];
+        if (t != LOAD_NEWLINE) {
+          dst[j] = t;
+          start_col = t == START ? j : start_col;
+          end_col = t == END ? j : end_col;
+          j++;
+        }
+      }
+    }
+    if (start_col >= 0) {
+      maze->start_row = i;
+      maze->start_col = start_col;
+    }
+    if (end_col >= 0) {
+      maze->end_row = i;
+      maze->end_col = end_col;
+    }
+  }
+}
+
+// Reads the text maze `fname` by mapping it, logging by `log_level`
+// like maze_read_file(). Gives the same maze as the fscanf() loader;
+// the tiles start on the line after "tiles:". Returns NULL after
+// printing an error if the file cannot be read.
+maze_t *maze_load_mapped(char *fname, int log_level) {
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    maze_load_error("ERROR: could not open file %s\n", fname);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return NULL;
+  }
+  unsigned char *data = st.st_size > 0 ?
+    mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (data == MAP_FAILED) {
+    maze_load_error("ERROR: could not map file %s\n", fname);
+    return NULL;
+  }
+  long size = st.st_size;
+
+  // The size line and "tiles:" are parsed from a terminated copy
+  char head[256];
+  long head_len = size < (long) sizeof(head) - 1 ? size : (long) sizeof(head) - 1;
+  memcpy(head, data, head_len);
+  head[head_len] = '\0';
+  int rows = 0, cols = 0, pos = 0;
+  if (sscanf(head, "rows: %d cols: %d tiles:%n", &rows, &cols, &pos) != 2 || pos == 0 ||
+      rows <= 0 || cols <= 0) {
+    maze_load_error("ERROR: could not read the size of maze %s\n", fname);
+    munmap(data, size);
+    return NULL;
+  }
+  long p = pos;
+  p += p < size && data[p] == '\r';
+  p += p < size && data[p] == '\n';
+
+  maze_t *maze = maze_allocate(rows, cols);
+  if (maze == NULL) {
+    munmap(data, size);
+    return NULL;
+  }
+  maze->log_level = log_level;
+  unsigned char types[256];
+  load_type_table(types);
+  loadrow_t classify = load_row_scalar;
+#ifdef LOAD_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    classify = load_row_avx2;
+  }
+#endif
+
+  // Rows at fixed offsets are parsed in parallel, anything else serially
+  long fixed = p + (long) rows * (cols + 1);
+  if (size == fixed || size == fixed - 1) {
+    int bad_row = load_rows_parallel(maze, data, size, p, classify, types);
+    if (bad_row < 0) {
+      munmap(data, size);
+      return maze;
+    }
+  }
+  load_check_rows(fname, data, size, p, rows, cols);
+  madvise(data, size, MADV_SEQUENTIAL);
+  load_rows_serial(maze, data, size, p, classify, types);
+  munmap(data, size);
+  return maze;
+}
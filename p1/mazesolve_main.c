@@ -1,50 +1,285 @@
 #include "mazesolve.h"
 
-// Function to load the maze and set log level if required
-maze_t* load_maze(int argc, char *argv[]) {
-    maze_t *maze = NULL;
-    
-    // If there are 4 arguments, the log level is set by the second argument
-    if (argc == 4) {
-        LOG_LEVEL = atoi(argv[2]); // Set log level from command line argument
-        maze = maze_from_file(argv[3]); // Load the maze from the file
-    } else if (argc == 2) {
-        maze = maze_from_file(argv[1]); // Only load maze if 2 arguments
-    }
-
-    return maze;
+// Options controlling how the maze is solved
+int flood = 0;                  // 1 to flood the whole maze rather than stopping at End
+int stats = 0;                  // 1 to print search statistics after solving
+maze_engine_t *engine = &maze_engines[0]; // engine used to search from Start to End
+char *sources_file = NULL;      // file of tiles to report distances to End from, NULL for none
+int serve = 0;                  // 1 to answer queries from stdin instead of solving once
+char *socket_path = NULL;       // Unix socket to answer queries on, NULL for none
+long cache_mb = 256;            // megabytes of BFS results cached while serving queries
+char *alt_file = NULL;          // landmark file for the alt engine, NULL to build landmarks in memory
+char *alt_build_file = NULL;    // file to write landmark tables to instead of solving, NULL for none
+char *edits_file = NULL;        // batches of tile edits to repair the flood through, NULL for none
+char *extern_dir = NULL;        // work directory to solve out of core in, NULL to load the maze
+long mem_mb = 256;              // megabytes of maze bands resident during an out-of-core solve
+int kernel = -1;                // 1 for the instrumented BFS kernel, 0 for production, -1 to pick by -log
+int batch = 0;                  // 1 if the last argument is a directory or list of maze files
+int workers = 0;                // threads solving a batch, 0 for one per online CPU
+char *batch_outdir = NULL;      // directory of per-maze batch outputs, NULL for stdout
+char *binary_file = NULL;       // file to convert the maze to the binary format in, NULL for none
+char *text_file = NULL;         // file to convert the maze to the text format in, NULL for none
+int components = 0;             // 1 to label connected components and skip searches between them
+
+// Function to parse options and set log level if required; returns 1
+// if an option is not recognized
+int parse_options(int argc, char *argv[]) {
+    // Options come before the maze file which is always the last argument
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "-log") == 0 && i + 1 < argc - 1) {
+            LOG_LEVEL = atoi(argv[++i]); // Set log level from command line argument
+        } else if (strcmp(argv[i], "-flood") == 0) {
+            flood = 1;
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc - 1) {
+            BFS_THREADS = atoi(argv[++i]); // Threads for the parallel engine
+        } else if (strcmp(argv[i], "-sources") == 0 && i + 1 < argc - 1) {
+            sources_file = argv[++i];
+        } else if (strcmp(argv[i], "-serve") == 0) {
+            serve = 1;
+        } else if (strcmp(argv[i], "-socket") == 0 && i + 1 < argc - 1) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-cache-mb") == 0 && i + 1 < argc - 1) {
+            cache_mb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-landmarks") == 0 && i + 1 < argc - 1) {
+            ALT_COUNT = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-alt") == 0 && i + 1 < argc - 1) {
+            alt_file = argv[++i];
+        } else if (strcmp(argv[i], "-alt-build") == 0 && i + 1 < argc - 1) {
+            alt_build_file = argv[++i];
+        } else if (strcmp(argv[i], "-edits") == 0 && i + 1 < argc - 1) {
+            edits_file = argv[++i];
+        } else if (strcmp(argv[i], "-external") == 0 && i + 1 < argc - 1) {
+            extern_dir = argv[++i];
+        } else if (strcmp(argv[i], "-mem-mb") == 0 && i + 1 < argc - 1) {
+            mem_mb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-kernel") == 0 && i + 1 < argc - 1) {
+            i++;
+            if (strcmp(argv[i], "instrumented") == 0) {
+                kernel = 1;
+            } else if (strcmp(argv[i], "production") == 0) {
+                kernel = 0;
+            } else {
+                printf("Error: unknown kernel '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-view") == 0 && i + 4 < argc - 1) {
+            PRINT_VIEW.row = atoi(argv[++i]);
+            PRINT_VIEW.col = atoi(argv[++i]);
+            PRINT_VIEW.rows = atoi(argv[++i]);
+            PRINT_VIEW.cols = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-batch") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc - 1) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc - 1) {
+            batch_outdir = argv[++i];
+        } else if (strcmp(argv[i], "-load-threads") == 0 && i + 1 < argc - 1) {
+            LOAD_THREADS = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-to-binary") == 0 && i + 1 < argc - 1) {
+            binary_file = argv[++i];
+        } else if (strcmp(argv[i], "-to-text") == 0 && i + 1 < argc - 1) {
+            text_file = argv[++i];
+        } else if (strcmp(argv[i], "-components") == 0) {
+            components = 1;
+        } else if (strcmp(argv[i], "-engine") == 0 && i + 1 < argc - 1) {
+            engine = maze_engine_lookup(argv[++i]);
+            if (engine == NULL) {
+                printf("Error: unknown engine '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            printf("Error: unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Only engines that search every reachable tile can flood
+    if (flood && engine->flood == NULL) {
+        printf("Error: the %s engine cannot -flood\n", engine->name);
+        return 1;
+    }
+
+    // Only the instrumented BFS can log; without logging the
+    // production kernel is used unless asked for otherwise
+    BFS_INSTRUMENTED = kernel >= 0 ? kernel : LOG_LEVEL > 0;
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
     // Check if the number of arguments is correct
-    if (argc != 2 && argc != 4) {
-        printf("Usage: %s [-log N] <maze-file>\n", argv[0]);
+    if (argc < 2) {
+        printf("Usage: %s [-log N] [-flood] [-stats] [-threads N] [-sources FILE] [-engine ", argv[0]);
+        maze_print_engines(stdout);
+        printf("] [-serve | -socket PATH] [-cache-mb N]\n");
+        printf("       [-landmarks K] [-alt FILE | -alt-build FILE] [-edits FILE]\n");
+        printf("       [-external DIR [-mem-mb N]] [-kernel instrumented|production]\n");
+        printf("       [-view ROW COL ROWS COLS] [-to-binary FILE | -to-text FILE] [-load-threads N]\n");
+        printf("       [-components]\n");
+        printf("       <maze-file>\n");
+        printf("       %s -batch [-workers N] [-out DIR] [-engine NAME] <dir | list-file>\n", argv[0]);
         return 1; // Exit if incorrect number of arguments
     }
 
+    // Mazes solved out of core are streamed from the file in bands
+    // rather than loaded
+    int bad_options = parse_options(argc, argv);
+    if (!bad_options && extern_dir != NULL) {
+        return maze_extern_solve(argv[argc - 1], extern_dir, mem_mb * 1024 * 1024, stats, stdout);
+    }
+
+    // A batch names many mazes which are solved on a pool of threads
+    if (!bad_options && batch) {
+        int count;
+        char **files = maze_batch_files(argv[argc - 1], &count);
+        if (files == NULL) {
+            return 1;
+        }
+        int ret = maze_batch_solve(files, count, engine, workers, batch_outdir, stdout);
+        maze_batch_files_free(files, count);
+        return ret;
+    }
+
     // Load the maze based on the command-line arguments
-    maze_t *maze = load_maze(argc, argv);
+    maze_t *maze = bad_options ? NULL : maze_from_file(argv[argc - 1]);
     if (maze == NULL) {
         printf("Error: Could not load maze file. Exiting with error code 1\n");
         return 1;
     }
 
+    // Convert the maze between the text and binary formats rather than solving
+    if (binary_file != NULL || text_file != NULL) {
+        int ret = binary_file != NULL ? maze_save_binary(maze, binary_file) : maze_save_text(maze, text_file);
+        maze_free(maze);
+        return ret;
+    }
+
+    // Preprocess landmarks into a file rather than solving
+    if (alt_build_file != NULL) {
+        alt_t *alt = maze_alt_build(maze, ALT_COUNT);
+        int ret = alt == NULL || maze_alt_save(alt, alt_build_file);
+        if (!ret) {
+            printf("wrote %d landmarks to %s\n", alt->count, alt_build_file);
+        }
+        if (alt != NULL) {
+            maze_alt_free(alt);
+        }
+        maze_free(maze);
+        return ret;
+    }
+    if (alt_file != NULL) {
+        ALT_LANDMARKS = maze_alt_load(maze, alt_file);
+        if (ALT_LANDMARKS == NULL) {
+            maze_free(maze);
+            return 1;
+        }
+    }
+
+    // Label components so unreachable Start/End pairs need no search
+    if (components) {
+        maze_components_build(maze);
+    }
+
+    // Answer queries against the loaded maze rather than solving once
+    if (serve || socket_path != NULL) {
+        maze_cache_t *cache = maze_cache_allocate(maze, cache_mb * 1024 * 1024);
+        int ret = 0;
+        if (socket_path != NULL) {
+            ret = maze_serve_socket(maze, cache, socket_path);
+        } else {
+            maze_serve(maze, cache, stdin, stdout);
+        }
+        maze_cache_print_stats(cache, stdout);
+        maze_cache_free(cache);
+        maze_free(maze);
+        return ret;
+    }
+
     // Display initial maze info
     maze_print_tiles(maze);
 
-    // Run BFS algorithm to solve the maze
-    maze_bfs_iterate(maze);
+    // Run the engine to solve the maze, or its flood form with -flood;
+    // logging BFS steps shows the full flood so it also implies -flood
+    // for the default engine. With
+    // edits the flood is repaired after each batch and the solution is
+    // that of the edited maze. The multi engine is run here so its
+    // Start/End pairs can be reported, flooding with -flood. With
+    // -components no search is run between different components.
+    maze_multi_t *multi = NULL;
+    if (edits_file != NULL) {
+        editlist_t *edits = maze_edits_from_file(edits_file);
+        if (edits == NULL) {
+            maze_free(maze);
+            return 1;
+        }
+        int failed = maze_repair_benchmark(maze, edits, stdout);
+        maze_edits_free(edits);
+        if (failed) {
+            maze_free(maze);
+            return 1;
+        }
+    } else if (engine->solve == maze_multi_solve) {
+        multi = maze_multi_search(maze, !flood);
+    } else if (maze->component != NULL &&
+               !maze_connected(maze, maze->start_row, maze->start_col, maze->end_row, maze->end_col)) {
+        maze->expanded = 0;  // Start and End are in different components
+    } else if (flood || (engine == &maze_engines[0] && LOG_LEVEL >= LOG_BFS_STEPS)) {
+        engine->flood(maze);
+    } else {
+        engine->solve(maze);
+    }
     maze_set_solution(maze);
 
     // Check if a solution exists and print the result
-    if (maze->tiles[maze->end_row][maze->end_col].path == NULL) {
+    tile_t *end = maze_end_tile(maze);
+    if (end == NULL || end->path == NULL) {
         printf("No solution found.\n");
     } else {
         printf("SOLUTION:\n");
         maze_print_tiles(maze); // Print the maze with the solution path
-        tile_print_path(&(maze->tiles[maze->end_row][maze->end_col]), PATH_FORMAT_VERBOSE); // Print the solution steps
+        tile_print_path(end, PATH_FORMAT_VERBOSE); // Print the solution steps
+        if (maze->path_cost >= 0) {
+            printf("path cost: %ld\n", maze->path_cost);
+        }
+    }
+    if (multi != NULL) {
+        maze_multi_print(maze, multi, flood, stdout);
+        maze_multi_free(multi);
+    }
+
+    if (stats) {
+        printf("tiles expanded: %ld\n", maze->expanded);
+        if (maze->component != NULL) {
+            printf("components: %d\n", maze->component_count);
+        }
     }
 
+    // Report the distance to End from each source tile, all found by
+    // one multi-source BFS pass per 64 sources
+    if (sources_file != NULL) {
+        int count;
+        rcnode_t *sources = maze_sources_from_file(sources_file, &count);
+        if (sources != NULL) {
+            int *dist = malloc(sizeof(int) * (count > 0 ? count : 1));
+            maze_msbfs_distances_to(maze, count, sources, maze->end_row, maze->end_col, dist);
+            for (int s = 0; s < count; s++) {
+                int d = dist[s];
+                printf("source (%d,%d): ", sources[s].row, sources[s].col);
+                if (d < 0) {
+                    printf("End unreachable\n");
+                } else {
+                    printf("distance to End %d\n", d);
+                }
+            }
+            free(dist);
+            free(sources);
+        }
+    }
+
+    if (ALT_LANDMARKS != NULL) {
+        maze_alt_free(ALT_LANDMARKS);
+    }
     maze_free(maze); // Free the maze resources
     return 0;
-}
\ No newline at end of file
+}
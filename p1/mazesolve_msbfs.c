@@ -0,0 +1,163 @@
+// mazesolve_msbfs.c: multi-source BFS advancing 64 searches together
+#include "mazesolve.h"
+
+// A multi-source BFS (MS-BFS) runs up to 64 independent BFS searches
+// at once. Every tile holds 64-bit masks with one bit per search:
+// `seen` marks the searches that have reached the tile and `visit`
+// those for which it is in the current layer. Expanding a frontier
+// tile pushes its whole visit mask to each neighbor at once,
+//
+//   next[n] |= visit[v] & ~seen[n]
+//
+// so a tile shared by the frontiers of many searches is expanded once
+// for all of them instead of once per search. Searches from nearby
+// sources overlap for most of the maze which makes this much cheaper
+// than repeating maze_bfs_iterate() for each source.
+
+#define MSBFS_WIDTH 64          // searches advanced together, one bit of a uint64_t each
+
+typedef struct {                // search masks of one tile, kept together for locality
+  uint64_t seen;                // searches that have reached the tile
+  uint64_t visit[2];            // searches with the tile in the even/odd numbered layer
+} msbfs_tile_t;
+
+// Runs one MS-BFS for up to MSBFS_WIDTH sources. With a negative
+// `target` fills their rows of `dist`; otherwise fills dist[s] with
+// the distance from source s to grid index `target` only and stops
+// once every search has reached it.
+static void msbfs_batch(maze_t *maze, int count, rcnode_t *sources, int *dist, int target) {
+  long cells = MAZE_CELLS(maze);
+  msbfs_tile_t *tiles = calloc(cells, sizeof(msbfs_tile_t));
+  int *layer = malloc(sizeof(int) * cells);       // tiles in the current layer of any search
+  int *next_layer = malloc(sizeof(int) * cells);  // tiles in the next layer of any search
+  long layer_count = 0;
+  uint64_t searches = 0;        // searches from sources inside the maze
+
+  for (int s = 0; s < count; s++) {
+    int row = sources[s].row, col = sources[s].col;
+    if (row < 0 || row >= maze->rows || col < 0 || col >= maze->cols || MAZE_TYPE(maze, row, col) == WALL) {
+      continue;  // no tiles reachable, the row stays at -1
+    }
+    int idx = MAZE_INDEX(maze, row, col);
+    if (tiles[idx].visit[0] == 0) {
+      layer[layer_count++] = idx;
+    }
+    tiles[idx].visit[0] |= 1ULL << s;
+    tiles[idx].seen |= 1ULL << s;
+    searches |= 1ULL << s;
+    if (target < 0) {
+      dist[s * cells + idx] = 0;
+    } else if (idx == target) {
+      dist[s] = 0;
+    }
+  }
+
+  for (int d = 1; layer_count > 0 && (target < 0 || tiles[target].seen != searches); d++) {
+    int cur_parity = (d - 1) & 1, next_parity = d & 1;
+
+    // Push each frontier tile's searches to its neighbors
+    long next_count = 0;
+    for (long f = 0; f < layer_count; f++) {
+      int cur = layer[f];
+      uint64_t visit = tiles[cur].visit[cur_parity];
+      tiles[cur].visit[cur_parity] = 0;  // clear for reuse two layers on
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        int n = cur + DIR_OFFSET(maze, dir_delta[i]);
+        if (maze->grid[n] == WALL) {
+          continue;
+        }
+        uint64_t reach = visit & ~tiles[n].seen;
+        if (reach == 0) {
+          continue;
+        }
+        if (tiles[n].visit[next_parity] == 0) {
+          next_layer[next_count++] = n;
+        }
+        tiles[n].visit[next_parity] |= reach;
+        tiles[n].seen |= reach;
+      }
+    }
+
+    // Record the distance of each search that reached a new tile, or
+    // only of those that reached the target
+    if (target < 0) {
+      for (long f = 0; f < next_count; f++) {
+        int n = next_layer[f];
+        for (uint64_t bits = tiles[n].visit[next_parity]; bits != 0; bits &= bits - 1) {
+          dist[__builtin_ctzll(bits) * cells + n] = d;
+        }
+      }
+    } else {
+      for (uint64_t bits = tiles[target].visit[next_parity]; bits != 0; bits &= bits - 1) {
+        dist[__builtin_ctzll(bits)] = d;
+      }
+    }
+
+    int *tmp_layer = layer;
+    layer = next_layer;
+    next_layer = tmp_layer;
+    layer_count = next_count;
+  }
+
+  free(tiles);
+  free(layer);
+  free(next_layer);
+}
+
+// Computes the BFS distance from each of the `count` tiles in
+// `sources` to every tile of `maze`. `dist` must have room for
+// count*MAZE_CELLS(maze) ints; the distances from source s occupy
+// dist[s*MAZE_CELLS(maze)] onward, indexed like the grid, with -1 for
+// tiles the source cannot reach. Sources are searched MSBFS_WIDTH at a
+// time. Sources outside the maze or on a WALL reach no tiles.
+void maze_msbfs_distances(maze_t *maze, int count, rcnode_t *sources, int *dist) {
+  long cells = MAZE_CELLS(maze);
+  memset(dist, 0xFF, sizeof(int) * cells * count);  // every distance -1
+  for (int first = 0; first < count; first += MSBFS_WIDTH) {
+    int batch = count - first < MSBFS_WIDTH ? count - first : MSBFS_WIDTH;
+    msbfs_batch(maze, batch, &sources[first], &dist[first * cells], -1);
+  }
+}
+
+// Computes the BFS distance from each of the `count` tiles in
+// `sources` to the single tile at row/col into dist[s], -1 if source s
+// cannot reach it, like maze_msbfs_distances() but needing only
+// `count` ints rather than a full grid of distances per source. Each
+// batch of MSBFS_WIDTH searches stops once all of them reach the tile.
+void maze_msbfs_distances_to(maze_t *maze, int count, rcnode_t *sources, int row, int col, int *dist) {
+  memset(dist, 0xFF, sizeof(int) * count);  // every distance -1
+  if (row < 0 || row >= maze->rows || col < 0 || col >= maze->cols || MAZE_TYPE(maze, row, col) == WALL) {
+    return;  // no source reaches the tile
+  }
+  int target = MAZE_INDEX(maze, row, col);
+  for (int first = 0; first < count; first += MSBFS_WIDTH) {
+    int batch = count - first < MSBFS_WIDTH ? count - first : MSBFS_WIDTH;
+    msbfs_batch(maze, batch, &sources[first], &dist[first], target);
+  }
+}
+
+// Reads source tiles from `fname`, one "row col" pair per line.
+// Returns an array of them and sets *countp to its length, or prints
+// an error and returns NULL if the file cannot be opened.
+rcnode_t *maze_sources_from_file(char *fname, int *countp) {
+  FILE *fin = fopen(fname, "r");
+  if (fin == NULL) {
+    printf("ERROR: could not open sources file %s\n", fname);
+    return NULL;
+  }
+  int capacity = RCQUEUE_MIN_CAPACITY, count = 0;
+  rcnode_t *sources = malloc(sizeof(rcnode_t) * capacity);
+  int row, col;
+  while (fscanf(fin, "%d %d", &row, &col) == 2) {
+    if (count == capacity) {
+      capacity *= 2;
+      sources = realloc(sources, sizeof(rcnode_t) * capacity);
+    }
+    sources[count].row = row;
+    sources[count].col = col;
+    count++;
+  }
+  fclose(fin);
+  *countp = count;
+  return sources;
+}
@@ -0,0 +1,201 @@
+// mazesolve_multi.c: one BFS seeded from every Start tile toward every End tile
+#include "mazesolve.h"
+
+// Maze files may hold several S and E tiles; the loaders keep the last
+// of each in start_row/col and end_row/col but leave every one of them
+// in the grid. Rather than searching from each Start to each End, one
+// BFS is seeded with all Start tiles at distance 0. Each tile is
+// reached first from its nearest Start, so it inherits that Start as
+// its label along with its distance and predecessor direction, and the
+// first End tile reached is the end of the shortest route between any
+// Start and any End. The whole sweep is O(tiles) whatever the number
+// of Starts and Ends.
+//
+// Afterwards the maze's Start and End are moved to the closest pair so
+// maze_set_solution() rebuilds their route: predecessors along it lead
+// back to that Start, where they stop as every Start is a seed.
+
+// Adds the row/col of every tile of type `type` to a new array in grid
+// order and sets `*count` to their number.
+static rcnode_t *multi_collect(maze_t *maze, tiletype_t type, int *count) {
+  int capacity = 4;
+  rcnode_t *tiles = malloc(sizeof(rcnode_t) * capacity);
+  *count = 0;
+  for (int i = 0; i < maze->rows; i++) {
+    unsigned char *grid = &MAZE_TYPE(maze, i, 0);
+    for (int j = 0; j < maze->cols; j++) {
+      if (grid[j] != type) {
+        continue;
+      }
+      if (*count == capacity) {
+        capacity *= 2;
+        tiles = realloc(tiles, sizeof(rcnode_t) * capacity);
+      }
+      tiles[*count].row = i;
+      tiles[*count].col = j;
+      (*count)++;
+    }
+  }
+  return tiles;
+}
+
+// Searches from all Start tiles at once. With `stop_at_end` the search
+// stops at the first End tile reached; otherwise every reachable tile
+// is labelled with its nearest Start and every End with its distance.
+// Ties between equally near Starts go to the one earlier in grid
+// order. Moves the maze's Start/End to the closest pair if an End is
+// reachable and leaves the number of expanded tiles in
+// maze->expanded. Returns the labels and the closest pair, to be freed
+// with maze_multi_free(), or NULL if the maze has no Start or no End.
+maze_multi_t *maze_multi_search(maze_t *maze, int stop_at_end) {
+  maze->expanded = 0;
+  if (maze->start_row < 0 || maze->end_row < 0) {
+    return NULL;  // need at least one Start and one End to search between
+  }
+  maze_search_reset(maze);
+
+  long cells = MAZE_CELLS(maze);
+  maze_multi_t *multi = malloc(sizeof(maze_multi_t));
+  multi->starts = multi_collect(maze, START, &multi->start_count);
+  multi->ends = multi_collect(maze, END, &multi->end_count);
+  multi->label = malloc(sizeof(int) * cells);
+  multi->dist = malloc(sizeof(int) * cells);
+  multi->best_start = multi->best_end = multi->best_dist = -1;
+
+  // Every Start is FOUND at distance 0 with itself as label; each tile
+  // is queued once so the queue needs no wrap around
+  int *queue = malloc(sizeof(int) * cells);
+  long head = 0, tail = 0;
+  for (int s = 0; s < multi->start_count; s++) {
+    int idx = MAZE_INDEX(maze, multi->starts[s].row, multi->starts[s].col);
+    BITSET_SET(maze->found, idx);
+    multi->label[idx] = s;
+    multi->dist[idx] = 0;
+    if (maze->dist != NULL) {
+      maze->dist[idx] = 0;
+    }
+    queue[tail++] = idx;
+  }
+
+  int reached = -1;             // grid index of the first End reached, -1 if none
+  while (head < tail && !(stop_at_end && reached >= 0)) {
+    int cur = queue[head++];
+    maze->expanded++;
+    if (maze->log_level >= LOG_BFS_STEPS) {
+      printf("LOG: processing neighbors of (%d,%d) for start %d\n",
+             cur / maze->stride - 1, cur % maze->stride - 1, multi->label[cur]);
+    }
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      int next = cur + DIR_OFFSET(maze, dir);
+      if (maze->grid[next] == WALL || BITSET_GET(maze->found, next)) {
+        continue;
+      }
+      BITSET_SET(maze->found, next);
+      PRED_SET(maze->pred, next, dir);
+      multi->label[next] = multi->label[cur];
+      multi->dist[next] = multi->dist[cur] + 1;
+      if (maze->dist != NULL) {
+        maze->dist[next] = multi->dist[next];
+      }
+      queue[tail++] = next;
+      if (maze->grid[next] == END && reached < 0) {
+        reached = next;  // BFS reaches Ends in order of distance
+        if (stop_at_end) {
+          break;
+        }
+      }
+    }
+  }
+  free(queue);
+
+  // Move the maze's Start and End to the closest pair
+  if (reached >= 0) {
+    int row = reached / maze->stride - 1, col = reached % maze->stride - 1;
+    for (int e = 0; e < multi->end_count; e++) {
+      if (multi->ends[e].row == row && multi->ends[e].col == col) {
+        multi->best_end = e;
+      }
+    }
+    multi->best_start = multi->label[reached];
+    multi->best_dist = multi->dist[reached];
+    maze->start_row = multi->starts[multi->best_start].row;
+    maze->start_col = multi->starts[multi->best_start].col;
+    maze->end_row = row;
+    maze->end_col = col;
+  }
+  return multi;
+}
+
+// Frees the result of maze_multi_search().
+void maze_multi_free(maze_multi_t *multi) {
+  free(multi->starts);
+  free(multi->ends);
+  free(multi->label);
+  free(multi->dist);
+  free(multi);
+}
+
+// Prints the closest Start/End pair found by maze_multi_search() to
+// `out`. With `all` also prints the nearest Start of every End and the
+// number of tiles labelled with each Start, which are only complete
+// if the search did not stop at the first End.
+void maze_multi_print(maze_t *maze, maze_multi_t *multi, int all, FILE *out) {
+  fprintf(out, "multi: %d starts %d ends\n", multi->start_count, multi->end_count);
+  if (multi->best_end < 0) {
+    fprintf(out, "closest pair: none, no end is reachable\n");
+  } else {
+    rcnode_t *s = &multi->starts[multi->best_start], *e = &multi->ends[multi->best_end];
+    fprintf(out, "closest pair: start %d (%d,%d) end %d (%d,%d) distance %d\n",
+            multi->best_start, s->row, s->col, multi->best_end, e->row, e->col, multi->best_dist);
+  }
+  if (!all) {
+    return;
+  }
+
+  for (int e = 0; e < multi->end_count; e++) {
+    int idx = MAZE_INDEX(maze, multi->ends[e].row, multi->ends[e].col);
+    fprintf(out, "end %d (%d,%d): ", e, multi->ends[e].row, multi->ends[e].col);
+    if (BITSET_GET(maze->found, idx)) {
+      rcnode_t *s = &multi->starts[multi->label[idx]];
+      fprintf(out, "start %d (%d,%d) distance %d\n", multi->label[idx], s->row, s->col, multi->dist[idx]);
+    } else {
+      fprintf(out, "unreachable\n");
+    }
+  }
+
+  long *claimed = calloc(multi->start_count, sizeof(long));
+  for (long idx = 0; idx < MAZE_CELLS(maze); idx++) {
+    if (BITSET_GET(maze->found, idx)) {
+      claimed[multi->label[idx]]++;
+    }
+  }
+  for (int s = 0; s < multi->start_count; s++) {
+    fprintf(out, "start %d (%d,%d): nearest start of %ld tiles\n",
+            s, multi->starts[s].row, multi->starts[s].col, claimed[s]);
+  }
+  free(claimed);
+}
+
+// Shortest route from any Start to any End.
+int maze_multi_solve(maze_t *maze) {
+  maze_multi_t *multi = maze_multi_search(maze, 1);
+  if (multi == NULL) {
+    return 0;
+  }
+  int solved = multi->best_end >= 0;
+  maze_multi_free(multi);
+  return solved;
+}
+
+// Labels every reachable tile with its nearest Start and solves the
+// closest Start/End pair.
+int maze_multi_flood(maze_t *maze) {
+  maze_multi_t *multi = maze_multi_search(maze, 0);
+  if (multi == NULL) {
+    return 0;
+  }
+  int solved = multi->best_end >= 0;
+  maze_multi_free(multi);
+  return solved;
+}
@@ -0,0 +1,223 @@
+// mazesolve_parallel.c: level-synchronous BFS split across pthreads
+#include "mazesolve.h"
+#include <pthread.h>
+#include <unistd.h>             // for sysconf()
+
+int BFS_THREADS = 0;            // threads used by the parallel engine, 0 for one per online CPU
+
+// The parallel BFS expands one whole layer of the search at a time.
+// The layer is kept as an array of grid indices in exactly the order
+// the serial queue would hold them and each thread expands a
+// contiguous slice of it in two passes separated by barriers:
+//
+// 1. Claim: every unFOUND open neighbor is claimed with the key
+//    4*position+direction of the tile reaching it, keeping the
+//    smallest key with an atomic compare-and-swap. The smallest key
+//    is the tile and direction that would reach the neighbor first in
+//    the serial BFS.
+// 2. Commit: each thread walks its slice again and the owner of each
+//    claim marks the neighbor FOUND with its predecessor and appends it
+//    to a thread-local list. FOUND bits and predecessors of different
+//    tiles share words so they are set with atomic ORs.
+//
+// Concatenating the local lists in thread order gives the next layer
+// in serial queue order, so predecessors, distances and FOUND tiles
+// are identical to maze_bfs_search() for any number of threads.
+
+#define PARBFS_UNCLAIMED UINT64_MAX
+
+typedef struct {                // state shared by the threads of one parallel BFS
+  maze_t *maze;                 // maze being searched
+  int threads;                  // number of threads expanding each layer
+  int end;                      // grid index of End, -1 to flood every reachable tile
+  int *layers[2];               // current and next layer as ordered grid indices
+  uint64_t *claim;              // smallest claim key of each tile, PARBFS_UNCLAIMED if none
+  int **local;                  // per-thread list of tiles committed in the current layer
+  long *local_count;            // length of each local list
+  long *local_capacity;         // allocated size of each local list
+  pthread_barrier_t barrier;    // separates the passes of each layer
+} parbfs_t;
+
+typedef struct {                // argument of one worker thread
+  parbfs_t *bfs;                // shared state
+  int id;                       // 0 to threads-1, fixes the thread's slice of each layer
+} parworker_t;
+
+// Appends grid index `idx` to the local list of thread `id`, doubling it when full.
+static void parbfs_append(parbfs_t *bfs, int id, int idx) {
+  if (bfs->local_count[id] == bfs->local_capacity[id]) {
+    bfs->local_capacity[id] *= 2;
+    bfs->local[id] = realloc(bfs->local[id], sizeof(int) * bfs->local_capacity[id]);
+  }
+  bfs->local[id][bfs->local_count[id]++] = idx;
+}
+
+// Runs the passes of every layer for one thread. All threads take
+// the same decisions from shared data after each barrier so they
+// leave the loop together; thread 0 keeps the expanded count.
+static void *parbfs_worker(void *arg) {
+  parworker_t *worker = arg;
+  parbfs_t *bfs = worker->bfs;
+  maze_t *maze = bfs->maze;
+  int id = worker->id;
+  int *layer = bfs->layers[0], *next = bfs->layers[1];
+  long count = 1;
+  int depth = 0;
+
+  while (count > 0) {
+    long lo = count * id / bfs->threads;
+    long hi = count * (id + 1) / bfs->threads;
+    if (id == 0 && maze->log_level >= LOG_BFS_STEPS) {
+      printf("LOG: parallel BFS layer %d: %ld tiles\n", depth, count);
+    }
+
+    // Claim pass: keep the smallest key for each unFOUND neighbor
+    for (long f = lo; f < hi; f++) {
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        int n = layer[f] + DIR_OFFSET(maze, dir_delta[i]);
+        if (maze->grid[n] == WALL || BITSET_GET(maze->found, n)) {
+          continue;
+        }
+        uint64_t key = (uint64_t) f * 4 + (i - DELTA_START);
+        uint64_t old = __atomic_load_n(&bfs->claim[n], __ATOMIC_RELAXED);
+        while (key < old && !__atomic_compare_exchange_n(&bfs->claim[n], &old, key, 1,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+      }
+    }
+    pthread_barrier_wait(&bfs->barrier);
+
+    // The serial BFS stops right after expanding the tile that finds
+    // End, so only the layer up to that tile is committed
+    int reached = bfs->end >= 0 && bfs->claim[bfs->end] != PARBFS_UNCLAIMED;
+    long stop = reached ? bfs->claim[bfs->end] / 4 + 1 : count;
+
+    // Commit pass: the owner of each claim marks the neighbor FOUND
+    bfs->local_count[id] = 0;
+    for (long f = lo; f < hi && f < stop; f++) {
+      for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+        direction_t dir = dir_delta[i];
+        int n = layer[f] + DIR_OFFSET(maze, dir);
+        if (bfs->claim[n] != (uint64_t) f * 4 + (i - DELTA_START)) {
+          continue;
+        }
+        __atomic_fetch_or(&maze->found[n >> 6], 1ULL << (n & 63), __ATOMIC_RELAXED);
+        __atomic_fetch_or(&maze->pred[n >> 2], (unsigned char) ((dir - NORTH) << PRED_SHIFT(n)),
+                          __ATOMIC_RELAXED);
+        if (maze->dist != NULL) {
+          maze->dist[n] = maze->dist[layer[f]] + 1;
+        }
+        parbfs_append(bfs, id, n);
+      }
+    }
+    pthread_barrier_wait(&bfs->barrier);
+
+    // Copy the local lists into the next layer in thread order
+    long offset = 0, total = 0;
+    for (int t = 0; t < bfs->threads; t++) {
+      if (t < id) {
+        offset += bfs->local_count[t];
+      }
+      total += bfs->local_count[t];
+    }
+    memcpy(&next[offset], bfs->local[id], sizeof(int) * bfs->local_count[id]);
+    pthread_barrier_wait(&bfs->barrier);
+
+    if (id == 0) {
+      maze->expanded += stop;
+    }
+    if (reached) {
+      break;  // End was found; the serial BFS stops here too
+    }
+    int *tmp = layer;
+    layer = next;
+    next = tmp;
+    count = total;
+    depth++;
+  }
+  return NULL;
+}
+
+// Runs a BFS from the Start tile with BFS_THREADS threads expanding
+// each layer. If `stop_at_end` is nonzero the search stops as soon as
+// the End tile is FOUND, otherwise it floods every reachable tile.
+// FOUND tiles, predecessors, distances and maze->expanded are the
+// same as after maze_bfs_search(). Returns 1 if the End tile was
+// FOUND and 0 otherwise.
+int maze_parallel_search(maze_t *maze, int stop_at_end) {
+  maze->expanded = 0;
+  if (maze->start_row < 0) {
+    return 0;  // Nothing to search from without a Start tile.
+  }
+  maze_search_reset(maze);
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int end = maze->end_row >= 0 ? MAZE_INDEX(maze, maze->end_row, maze->end_col) : -1;
+  if (stop_at_end && end == start) {
+    return 1;  // Start is End, nothing to expand
+  }
+
+  parbfs_t bfs;
+  long cells = MAZE_CELLS(maze);
+  bfs.maze = maze;
+  bfs.threads = BFS_THREADS > 0 ? BFS_THREADS : (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (bfs.threads < 1) {
+    bfs.threads = 1;
+  }
+  bfs.end = stop_at_end ? end : -1;
+  bfs.layers[0] = malloc(sizeof(int) * cells);
+  bfs.layers[1] = malloc(sizeof(int) * cells);
+  bfs.layers[0][0] = start;
+  bfs.claim = malloc(sizeof(uint64_t) * cells);
+  memset(bfs.claim, 0xFF, sizeof(uint64_t) * cells);  // every key PARBFS_UNCLAIMED
+  bfs.local = malloc(sizeof(int *) * bfs.threads);
+  bfs.local_count = malloc(sizeof(long) * bfs.threads);
+  bfs.local_capacity = malloc(sizeof(long) * bfs.threads);
+  for (int t = 0; t < bfs.threads; t++) {
+    bfs.local_capacity[t] = maze_queue_capacity(maze);
+    bfs.local[t] = malloc(sizeof(int) * bfs.local_capacity[t]);
+  }
+  pthread_barrier_init(&bfs.barrier, NULL, bfs.threads);
+
+  // The calling thread works as thread 0
+  pthread_t *tids = malloc(sizeof(pthread_t) * bfs.threads);
+  parworker_t *workers = malloc(sizeof(parworker_t) * bfs.threads);
+  for (int t = 0; t < bfs.threads; t++) {
+    workers[t].bfs = &bfs;
+    workers[t].id = t;
+    if (t > 0) {
+      pthread_create(&tids[t], NULL, parbfs_worker, &workers[t]);
+    }
+  }
+  parbfs_worker(&workers[0]);
+  for (int t = 1; t < bfs.threads; t++) {
+    pthread_join(tids[t], NULL);
+  }
+
+  if (maze->log_level >= LOG_BFS_STEPS) {
+    printf("LOG: parallel BFS expanded %ld tiles with %d threads\n", maze->expanded, bfs.threads);
+  }
+
+  pthread_barrier_destroy(&bfs.barrier);
+  for (int t = 0; t < bfs.threads; t++) {
+    free(bfs.local[t]);
+  }
+  free(bfs.local);
+  free(bfs.local_count);
+  free(bfs.local_capacity);
+  free(bfs.claim);
+  free(bfs.layers[0]);
+  free(bfs.layers[1]);
+  free(tids);
+  free(workers);
+  return end >= 0 && BITSET_GET(maze->found, end);
+}
+
+// Parallel BFS that stops once the End tile is FOUND.
+int maze_parallel_solve(maze_t *maze) {
+  return maze_parallel_search(maze, 1);
+}
+
+// Parallel BFS flooding every tile reachable from Start.
+int maze_parallel_flood(maze_t *maze) {
+  return maze_parallel_search(maze, 0);
+}
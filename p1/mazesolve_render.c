@@ -0,0 +1,220 @@
+// mazesolve_render.c: buffered printing of maze tiles and BFS state
+#include "mazesolve.h"
+#include <unistd.h>
+
+// The printers format whole rows into one large buffer and hand it to
+// write() when full, rather than calling printf() for every tile, so
+// printing a huge maze costs little more than copying its tiles. Only
+// the tiles inside a view are drawn so a region of a huge maze can be
+// inspected without rendering the rest; the row labels and column
+// ruler of the state printer keep the coordinates of the maze.
+//
+// Output bypasses the stdio buffer of the FILE it is given: that
+// buffer is flushed first so earlier printf() output stays in order.
+// Streams without a file descriptor, such as those of open_memstream(),
+// are given the buffer with fwrite() instead.
+
+#define RENDER_BUFSIZE (1 << 20)  // bytes formatted before each write()
+#define RENDER_CHUNK   4096       // most tiles formatted per reservation
+
+// Window of the maze printed by maze_print_tiles() and
+// maze_print_state(); the whole maze by default.
+maze_view_t PRINT_VIEW = {0, 0, -1, -1};
+
+typedef struct {                // output buffer flushed with write()
+  char *data;                   // RENDER_BUFSIZE bytes
+  int len;                      // bytes formatted but not yet written
+  int fd;                       // file descriptor written to, -1 to fwrite() to out
+  FILE *out;                    // stream being printed to
+} renderbuf_t;
+
+static void render_open(renderbuf_t *buf, FILE *out) {
+  fflush(out);
+  buf->data = malloc(RENDER_BUFSIZE);
+  buf->len = 0;
+  buf->fd = fileno(out);
+  buf->out = out;
+}
+
+// Writes everything in the buffer, retrying short writes.
+static void render_flush(renderbuf_t *buf) {
+  if (buf->fd < 0) {
+    fwrite(buf->data, 1, buf->len, buf->out);
+    buf->len = 0;
+    return;
+  }
+  for (int done = 0; done < buf->len;) {
+    ssize_t n = write(buf->fd, buf->data + done, buf->len - done);
+    if (n <= 0) {
+      break;  // the output is gone; drop the rest as printf() would
+    }
+    done += n;
+  }
+  buf->len = 0;
+}
+
+static void render_close(renderbuf_t *buf) {
+  render_flush(buf);
+  free(buf->data);
+}
+
+// Returns space for `n` more bytes, flushing first if the buffer
+// lacks it. The caller adds the bytes it uses to len.
+static char *render_reserve(renderbuf_t *buf, int n) {
+  if (buf->len + n > RENDER_BUFSIZE) {
+    render_flush(buf);
+  }
+  return buf->data + buf->len;
+}
+
+static void render_printf(renderbuf_t *buf, char *fmt, ...) {
+  char *p = render_reserve(buf, 256);
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(p, 256, fmt, args);
+  va_end(args);
+  buf->len += n < 256 ? n : 255;
+}
+
+// Clips `view` to `maze`, giving the rows [r0,r1) and cols [c0,c1)
+// to draw. A negative size extends the view to the edge of the maze.
+static void render_clip(maze_t *maze, maze_view_t *view, int *r0, int *r1, int *c0, int *c1) {
+  *r0 = view->row < 0 ? 0 : view->row > maze->rows ? maze->rows : view->row;
+  *c0 = view->col < 0 ? 0 : view->col > maze->cols ? maze->cols : view->col;
+  *r1 = view->rows < 0 || view->rows > maze->rows - *r0 ? maze->rows : *r0 + view->rows;
+  *c1 = view->cols < 0 || view->cols > maze->cols - *c0 ? maze->cols : *c0 + view->cols;
+}
+
+// Prints the maze size, Start/End coordinates and the tiles of `view`
+// to `out`, the format of maze_print_tiles(). A view smaller than the
+// maze names the rows and cols it shows.
+void maze_render_tiles(maze_t *maze, maze_view_t *view, FILE *out) {
+  int r0, r1, c0, c1;
+  render_clip(maze, view, &r0, &r1, &c0, &c1);
+  renderbuf_t buf;
+  render_open(&buf, out);
+  render_printf(&buf, "maze: %d rows %d cols\n", maze->rows, maze->cols);
+  render_printf(&buf, "      (%d,%d) start\n", maze->start_row, maze->start_col);
+  render_printf(&buf, "      (%d,%d) end\n", maze->end_row, maze->end_col);
+  if (r0 == 0 && c0 == 0 && r1 == maze->rows && c1 == maze->cols) {
+    render_printf(&buf, "maze tiles:\n");
+  } else if (r0 == r1 || c0 == c1) {
+    render_printf(&buf, "maze tiles: none in view\n");
+  } else {
+    render_printf(&buf, "maze tiles rows %d-%d cols %d-%d:\n", r0, r1 - 1, c0, c1 - 1);
+  }
+
+  for (int i = r0; i < r1; i++) {
+    unsigned char *grid = &maze->grid[MAZE_INDEX(maze, i, 0)];
+    for (int j = c0; j < c1; j += RENDER_CHUNK) {
+      int n = c1 - j < RENDER_CHUNK ? c1 - j : RENDER_CHUNK;
+      char *p = render_reserve(&buf, n);
+      for (int k = 0; k < n; k++) {
+        p[k] = tiletype_chars[grid[j + k]];
+      }
+      buf.len += n;
+    }
+    *render_reserve(&buf, 1) = '\n';
+    buf.len++;
+  }
+  render_close(&buf);
+}
+
+// Distance from Start of the FOUND tile at `idx` when the maze tracks
+// no distances. Walking predecessors for every tile would be quadratic
+// in the path length, so distances of tiles in the window [r0,r1) x
+// [c0,c1) are kept in `memo` (-1 if unknown) and a walk stops at the
+// first one it meets. A second walk fills in the tiles it passed.
+static int render_distance(maze_t *maze, int *memo, int r0, int r1, int c0, int c1, int idx) {
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+  int wcols = c1 - c0;
+  int len = 0, base = 0, at = idx;
+  while (at != start) {
+    int r = at / maze->stride - 1, c = at % maze->stride - 1;
+    if (r >= r0 && r < r1 && c >= c0 && c < c1 && memo[(r - r0) * wcols + c - c0] >= 0) {
+      base = memo[(r - r0) * wcols + c - c0];
+      break;
+    }
+    at -= DIR_OFFSET(maze, PRED_GET(maze->pred, at));
+    len++;
+  }
+  int dist = base + len;
+  for (int d = dist; idx != at; d--) {
+    int r = idx / maze->stride - 1, c = idx % maze->stride - 1;
+    if (r >= r0 && r < r1 && c >= c0 && c < c1) {
+      memo[(r - r0) * wcols + c - c0] = d;
+    }
+    idx -= DIR_OFFSET(maze, PRED_GET(maze->pred, idx));
+  }
+  return dist;
+}
+
+// Prints the BFS state of the tiles of `view` to `out` with the row
+// labels and column ruler of maze_print_state(); the queue is left for
+// the caller. Distances past the end of digit10_chars[] wrap around.
+void maze_render_state(maze_t *maze, maze_view_t *view, FILE *out) {
+  int r0, r1, c0, c1;
+  render_clip(maze, view, &r0, &r1, &c0, &c1);
+  int *memo = NULL;
+  if (maze->dist == NULL && maze->pred != NULL) {
+    long window = (long) (r1 - r0) * (c1 - c0);
+    memo = malloc(sizeof(int) * (window > 0 ? window : 1));
+    memset(memo, -1, sizeof(int) * window);
+  }
+  int digit10_count = strlen(digit10_chars);
+  renderbuf_t buf;
+  render_open(&buf, out);
+
+  // Each row as FOUND distances or tile types, then its row number
+  for (int i = r0; i < r1; i++) {
+    for (int j = c0; j < c1; j += RENDER_CHUNK) {
+      int n = c1 - j < RENDER_CHUNK ? c1 - j : RENDER_CHUNK;
+      char *p = render_reserve(&buf, n);
+      for (int k = 0; k < n; k++) {
+        int idx = MAZE_INDEX(maze, i, j + k);
+        if (BITSET_GET(maze->found, idx)) {
+          int path_len = memo != NULL ? render_distance(maze, memo, r0, r1, c0, c1, idx)
+                                      : maze_pred_distance(maze, idx);
+          p[k] = path_len % 10 == 0 ? digit10_chars[(path_len / 10) % digit10_count]
+                                    : '0' + path_len % 10;
+        } else {
+          p[k] = tiletype_chars[maze->grid[idx]];
+        }
+      }
+      buf.len += n;
+    }
+    render_printf(&buf, ": %d\n", i);
+  }
+
+  // Column ruler: the last digit of each col, then the tens. From col
+  // 0 they follow the original maze_print_state() format, 0 and then
+  // one label after every col ending in 9; a view starting further
+  // right labels each col that is a multiple of 10 directly below it
+  int tens = 0;
+  for (int j = c0; j < c1; j += RENDER_CHUNK) {
+    int n = c1 - j < RENDER_CHUNK ? c1 - j : RENDER_CHUNK;
+    char *p = render_reserve(&buf, n);
+    for (int k = 0; k < n; k++) {
+      p[k] = '0' + (j + k) % 10;
+      tens += (j + k) % 10 == 9;
+    }
+    buf.len += n;
+  }
+  if (c0 == 0) {
+    render_printf(&buf, "\n0");
+    for (int i = 1; i < tens + 1; i++) {
+      render_printf(&buf, "%9d", i);
+    }
+  } else {
+    render_printf(&buf, "\n");
+    int pos = 0;                // cols of the view the labels so far cover
+    for (int k = (10 - c0 % 10) % 10; c0 + k < c1; k += 10) {
+      int n = snprintf(NULL, 0, "%d", (c0 + k) / 10);
+      render_printf(&buf, "%*s%d", k - pos, "", (c0 + k) / 10);
+      pos = k + n;
+    }
+  }
+  render_printf(&buf, "\n");
+  render_close(&buf);
+  free(memo);
+}
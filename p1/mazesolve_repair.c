@@ -0,0 +1,379 @@
+// mazesolve_repair.c: incremental repair of a BFS flood after tiles change between WALL and OPEN
+#include "mazesolve.h"
+#include <time.h>
+
+// When a few tiles flip between WALL and OPEN only the distances near
+// them can change, so rather than flooding the whole maze again the
+// flood from Start is repaired in two phases, as in Ramalingam and
+// Reps' dynamic shortest paths specialised to unit steps:
+//
+// 1. Invalidate: tiles that became WALL lose their subtree of the
+//    predecessor tree. Going outward in order of distance, a child of
+//    an affected tile keeps its distance if some unaffected neighbor is
+//    one step closer to Start and takes it as its new predecessor;
+//    otherwise it is affected too. Only affected tiles lose their
+//    FOUND bits.
+// 2. Propagate: the FOUND neighbors of affected tiles and of tiles that
+//    became OPEN seed a BFS that relaxes any tile it can bring closer,
+//    which both re-reaches affected tiles and shortens paths through
+//    newly opened tiles.
+//
+// Both phases visit tiles in nondecreasing distance by merging a list
+// of seeds sorted by distance with a FIFO of tiles they reach, which
+// always holds nondecreasing distances, so each tile is queued at most
+// once per phase. The work is proportional to the region whose
+// distances change rather than to the maze.
+
+// Tiles in distance order, smallest key first then smallest index
+static int repair_node_cmp(const void *a, const void *b) {
+  const heapnode_t *x = a, *y = b;
+  if (x->key != y->key) {
+    return x->key < y->key ? -1 : 1;
+  }
+  return x->idx - y->idx;
+}
+
+// Starts a phase from the seeds added since the last phase.
+static void repair_begin_phase(maze_repair_t *rep) {
+  qsort(rep->seeds, rep->seed_count, sizeof(heapnode_t), repair_node_cmp);
+  rep->seed_pos = 0;
+  rep->head = rep->tail = 0;
+}
+
+// Removes the tile with the smallest distance from the seeds and FIFO
+// into `node`. Returns 0 once both are empty.
+static int repair_pop(maze_repair_t *rep, heapnode_t *node) {
+  int seeds_left = rep->seed_pos < rep->seed_count;
+  int queued = rep->head < rep->tail;
+  if (!seeds_left && !queued) {
+    return 0;
+  }
+  if (seeds_left && (!queued || rep->seeds[rep->seed_pos].key <= rep->fifo[rep->head].key)) {
+    *node = rep->seeds[rep->seed_pos++];
+  } else {
+    *node = rep->fifo[rep->head++];
+  }
+  return 1;
+}
+
+// Marks tile `idx` affected and queues it at distance `dist` on the
+// seeds or the FIFO.
+static void repair_affect(maze_repair_t *rep, int idx, int dist, int seed) {
+  BITSET_SET(rep->affected, idx);
+  rep->touched[rep->affected_count++] = idx;
+  heapnode_t node = {.key = dist, .idx = idx};
+  if (seed) {
+    rep->seeds[rep->seed_count++] = node;
+  } else {
+    rep->fifo[rep->tail++] = node;
+  }
+}
+
+// Adds the FOUND open neighbors of tile `idx` as seeds of the
+// propagate phase, each at most once.
+static void repair_seed_neighbors(maze_t *maze, maze_repair_t *rep, int idx) {
+  for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+    int n = idx + DIR_OFFSET(maze, dir_delta[i]);
+    if (maze->grid[n] == WALL || !BITSET_GET(maze->found, n) ||
+        BITSET_GET(rep->affected, n) || BITSET_GET(rep->seeded, n)) {
+      continue;
+    }
+    BITSET_SET(rep->seeded, n);
+    rep->seeds[rep->seed_count++] = (heapnode_t) {.key = maze->dist[n], .idx = n};
+  }
+}
+
+// Floods `maze` from Start tracking distances and returns the scratch
+// state used to repair that flood with maze_repair_apply(). Scratch
+// arrays are allocated at full size but only touched as far as a
+// repair reaches.
+maze_repair_t *maze_repair_allocate(maze_t *maze) {
+  maze_bfs_track_distance(maze);
+  maze_bfs_iterate(maze);
+  long cells = MAZE_CELLS(maze);
+  maze_repair_t *rep = calloc(1, sizeof(maze_repair_t));
+  rep->affected = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  rep->seeded = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  rep->seeds = malloc(sizeof(heapnode_t) * cells);
+  rep->fifo = malloc(sizeof(heapnode_t) * cells);
+  rep->touched = malloc(sizeof(int) * cells);
+  return rep;
+}
+
+// Frees the repair scratch state; the maze keeps its flood.
+void maze_repair_free(maze_repair_t *rep) {
+  free(rep->affected);
+  free(rep->seeded);
+  free(rep->seeds);
+  free(rep->fifo);
+  free(rep->touched);
+  free(rep);
+}
+
+// Applies the `count` edits to the tiles of `maze` and repairs its
+// flood from Start so FOUND bits and distances are those a fresh
+// maze_bfs_iterate() would give and predecessors are shortest paths,
+// though ties may be broken differently. The maze must have been
+// flooded by maze_repair_allocate() or an earlier repair. Leaves the
+// tiles dequeued by both phases in maze->expanded and the number of
+// affected tiles in rep->affected_count. Drops any component labels
+// of the maze as the edits may join or split components. Returns 0
+// on success; if an edit is outside the maze, on Start or End, or not
+// WALL or OPEN prints an error and returns 1 without changing the
+// maze.
+int maze_repair_apply(maze_t *maze, maze_repair_t *rep, tileedit_t *edits, int count) {
+  for (int e = 0; e < count; e++) {
+    int row = edits[e].row, col = edits[e].col;
+    if (row < 0 || row >= maze->rows || col < 0 || col >= maze->cols) {
+      printf("ERROR: edit of tile (%d,%d) is outside the maze\n", row, col);
+      return 1;
+    }
+    if ((row == maze->start_row && col == maze->start_col) ||
+        (row == maze->end_row && col == maze->end_col)) {
+      printf("ERROR: edit of tile (%d,%d) would change Start or End\n", row, col);
+      return 1;
+    }
+    if (edits[e].type != WALL && edits[e].type != OPEN) {
+      printf("ERROR: edit of tile (%d,%d) must make it WALL or OPEN\n", row, col);
+      return 1;
+    }
+  }
+  for (int e = 0; e < count; e++) {
+    MAZE_TYPE(maze, edits[e].row, edits[e].col) = edits[e].type;
+  }
+  free(maze->component);  // component labels no longer match the walls
+  maze->component = NULL;
+  maze->expanded = 0;
+  rep->affected_count = 0;
+  rep->seed_count = 0;
+  if (maze->start_row < 0) {
+    return 0;  // Nothing is reachable without a Start tile.
+  }
+  int start = MAZE_INDEX(maze, maze->start_row, maze->start_col);
+
+  // Invalidate: FOUND tiles that are now WALL and the subtrees hanging
+  // off them that cannot be re-parented at the same distance
+  for (int e = 0; e < count; e++) {
+    int idx = MAZE_INDEX(maze, edits[e].row, edits[e].col);
+    if (maze->grid[idx] == WALL && BITSET_GET(maze->found, idx) && !BITSET_GET(rep->affected, idx)) {
+      repair_affect(rep, idx, maze->dist[idx], 1);
+    }
+  }
+  repair_begin_phase(rep);
+  heapnode_t node;
+  while (repair_pop(rep, &node)) {
+    maze->expanded++;
+    int cur = node.idx;
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      int n = cur + DIR_OFFSET(maze, dir_delta[i]);
+      if (maze->grid[n] == WALL || n == start || !BITSET_GET(maze->found, n) ||
+          BITSET_GET(rep->affected, n) || n - DIR_OFFSET(maze, PRED_GET(maze->pred, n)) != cur) {
+        continue;  // not a child of cur in the predecessor tree
+      }
+      // Every tile closer than cur has been dequeued so the affected
+      // bits at cur's distance are final
+      int kept = 0;
+      for (int j = DELTA_START; j < DELTA_COUNT && !kept; j++) {
+        direction_t dir = dir_delta[j];
+        int from = n - DIR_OFFSET(maze, dir);  // neighbor that steps `dir` into n
+        if (maze->grid[from] != WALL && BITSET_GET(maze->found, from) &&
+            !BITSET_GET(rep->affected, from) && maze->dist[from] == maze->dist[n] - 1) {
+          PRED_SET(maze->pred, n, dir);
+          kept = 1;
+        }
+      }
+      if (!kept) {
+        repair_affect(rep, n, maze->dist[n], 0);
+      }
+    }
+  }
+  for (long t = 0; t < rep->affected_count; t++) {
+    int idx = rep->touched[t];
+    maze->found[idx >> 6] &= ~(1ULL << (idx & 63));
+  }
+
+  // Propagate: BFS outward from the FOUND tiles bordering affected
+  // and newly opened tiles
+  rep->seed_count = 0;
+  for (long t = 0; t < rep->affected_count; t++) {
+    if (maze->grid[rep->touched[t]] != WALL) {
+      repair_seed_neighbors(maze, rep, rep->touched[t]);
+    }
+  }
+  for (int e = 0; e < count; e++) {
+    int idx = MAZE_INDEX(maze, edits[e].row, edits[e].col);
+    if (maze->grid[idx] != WALL && !BITSET_GET(maze->found, idx)) {
+      repair_seed_neighbors(maze, rep, idx);
+    }
+  }
+  for (long s = 0; s < rep->seed_count; s++) {
+    int idx = rep->seeds[s].idx;
+    rep->seeded[idx >> 6] &= ~(1ULL << (idx & 63));
+  }
+  repair_begin_phase(rep);
+  while (repair_pop(rep, &node)) {
+    int cur = node.idx;
+    int d = node.key;
+    if (maze->dist[cur] != d) {
+      continue;  // a seed brought closer by an opened tile since it was queued
+    }
+    maze->expanded++;
+    for (int i = DELTA_START; i < DELTA_COUNT; i++) {
+      direction_t dir = dir_delta[i];
+      int n = cur + DIR_OFFSET(maze, dir);
+      if (maze->grid[n] == WALL || (BITSET_GET(maze->found, n) && maze->dist[n] <= d + 1)) {
+        continue;
+      }
+      BITSET_SET(maze->found, n);
+      PRED_SET(maze->pred, n, dir);
+      maze->dist[n] = d + 1;
+      rep->fifo[rep->tail++] = (heapnode_t) {.key = d + 1, .idx = n};
+    }
+  }
+  for (long t = 0; t < rep->affected_count; t++) {
+    int idx = rep->touched[t];
+    rep->affected[idx >> 6] &= ~(1ULL << (idx & 63));
+  }
+  return 0;
+}
+
+// Reads batches of tile edits from `fname`. Each line is
+//
+//   row col wall|open
+//
+// and a blank line ends a batch; lines starting with '#' are comments.
+// Returns the edits or prints an error and returns NULL if the file
+// cannot be opened or a line cannot be parsed.
+editlist_t *maze_edits_from_file(char *fname) {
+  FILE *fin = fopen(fname, "r");
+  if (fin == NULL) {
+    printf("ERROR: could not open edit file %s\n", fname);
+    return NULL;
+  }
+  editlist_t *list = calloc(1, sizeof(editlist_t));
+  int capacity = RCQUEUE_MIN_CAPACITY, batch_capacity = RCQUEUE_MIN_CAPACITY;
+  list->edits = malloc(sizeof(tileedit_t) * capacity);
+  list->batch_end = malloc(sizeof(int) * batch_capacity);
+
+  char line[256];
+  int lineno = 0;
+  int more = 1;
+  while (more) {
+    more = fgets(line, sizeof(line), fin) != NULL;
+    lineno++;
+    int row, col;
+    char word[16];
+    int fields = more ? sscanf(line, "%d %d %15s", &row, &col, word) : EOF;
+    if (more && line[0] == '#') {
+      continue;
+    }
+    if (fields == EOF) {
+      // Blank line or end of file closes a non-empty batch
+      int first = list->batches > 0 ? list->batch_end[list->batches - 1] : 0;
+      if (list->count > first) {
+        if (list->batches == batch_capacity) {
+          batch_capacity *= 2;
+          list->batch_end = realloc(list->batch_end, sizeof(int) * batch_capacity);
+        }
+        list->batch_end[list->batches++] = list->count;
+      }
+      continue;
+    }
+    tiletype_t type = NOTSET;
+    if (fields == 3 && strcmp(word, "wall") == 0) {
+      type = WALL;
+    } else if (fields == 3 && strcmp(word, "open") == 0) {
+      type = OPEN;
+    }
+    if (type == NOTSET) {
+      printf("ERROR: %s line %d: expected 'row col wall' or 'row col open'\n", fname, lineno);
+      fclose(fin);
+      maze_edits_free(list);
+      return NULL;
+    }
+    if (list->count == capacity) {
+      capacity *= 2;
+      list->edits = realloc(list->edits, sizeof(tileedit_t) * capacity);
+    }
+    list->edits[list->count++] = (tileedit_t) {.row = row, .col = col, .type = type};
+  }
+  fclose(fin);
+  return list;
+}
+
+// Frees a list of edits from maze_edits_from_file().
+void maze_edits_free(editlist_t *list) {
+  free(list->edits);
+  free(list->batch_end);
+  free(list);
+}
+
+// Nanoseconds on the monotonic clock, for repair timings
+static long repair_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Floods `maze`, then applies each batch of `list` with
+// maze_repair_apply() and times it against a fresh maze_bfs_iterate()
+// of the edited maze, checking that both give the same FOUND tiles and
+// distances. Prints one line per batch and the totals to `out` and
+// leaves `maze` with all edits applied and its flood repaired. Returns
+// 0 if every batch applied and matched and 1 otherwise.
+int maze_repair_benchmark(maze_t *maze, editlist_t *list, FILE *out) {
+  maze_repair_t *rep = maze_repair_allocate(maze);
+
+  // A second maze sharing the grid holds the fresh floods
+  long cells = MAZE_CELLS(maze);
+  maze_t full = *maze;
+  full.found = calloc(BITSET_WORDS(cells), sizeof(uint64_t));
+  full.pred = NULL;
+  full.dist = malloc(sizeof(int) * cells);
+  full.queue = NULL;
+  full.solution.path = NULL;
+
+  long repair_ns = 0, full_ns = 0;
+  int ret = 0;
+  for (int b = 0; b < list->batches; b++) {
+    int first = b > 0 ? list->batch_end[b - 1] : 0;
+    int count = list->batch_end[b] - first;
+    long begin = repair_now_ns();
+    if (maze_repair_apply(maze, rep, &list->edits[first], count) != 0) {
+      ret = 1;
+      break;
+    }
+    long repaired = repair_now_ns();
+    maze_bfs_iterate(&full);
+    long flooded = repair_now_ns();
+    repair_ns += repaired - begin;
+    full_ns += flooded - repaired;
+
+    long mismatches = 0;
+    for (long i = 0; i < cells; i++) {
+      int found = BITSET_GET(maze->found, i);
+      if (found != BITSET_GET(full.found, i) || (found && maze->dist[i] != full.dist[i])) {
+        mismatches++;
+      }
+    }
+    fprintf(out, "batch %d: %d edits, %ld tiles affected, %ld expanded, repair %.3f ms, full BFS %.3f ms",
+            b + 1, count, rep->affected_count, maze->expanded, (repaired - begin) / 1e6, (flooded - repaired) / 1e6);
+    if (mismatches > 0) {
+      fprintf(out, ", %ld distance mismatches\n", mismatches);
+      ret = 1;
+    } else {
+      fprintf(out, "\n");
+    }
+  }
+  fprintf(out, "total: repair %.3f ms, full BFS %.3f ms, speedup %.1fx\n",
+          repair_ns / 1e6, full_ns / 1e6, repair_ns > 0 ? (double) full_ns / repair_ns : 0.0);
+
+  free(full.found);
+  free(full.pred);
+  free(full.dist);
+  if (full.queue != NULL) {
+    rcqueue_free(full.queue);
+  }
+  maze_repair_free(rep);
+  return ret;
+}
@@ -0,0 +1,278 @@
+// mazesolve_server.c: long-running query mode with an LRU cache of BFS results
+#include "mazesolve.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <signal.h>
+
+// The server loads a maze once and answers queries of the form
+//
+//   start_row start_col end_row end_col
+//
+// one per line with the length and compact path of a shortest path.
+// A query floods the maze from its start tile with maze_bfs_iterate()
+// and keeps the predecessors and FOUND bits in an LRU cache keyed by
+// the start tile, so later queries from the same start, to any end,
+// only walk the predecessors back from their end tile. The cache
+// evicts the least recently used starts to stay within a byte budget.
+//
+// If the maze has component labels, a query between tiles of different
+// components is answered "no path" at once without flooding, caching
+// or counting it among the queries.
+//
+// Besides queries the server understands "stats", which prints the
+// hit rate and latencies so far, and "quit", which stops it.
+
+// Nanoseconds on the monotonic clock, for query latencies
+static long server_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Allocates an empty cache for searches of `maze` holding at most
+// `budget` bytes of BFS results; at least one result is always kept.
+maze_cache_t *maze_cache_allocate(maze_t *maze, long budget) {
+  maze_cache_t *cache = calloc(1, sizeof(maze_cache_t));
+  cache->by_start = calloc(MAZE_CELLS(maze), sizeof(cacheentry_t *));
+  cache->entry_bytes = PRED_BYTES(MAZE_CELLS(maze)) + sizeof(uint64_t) * BITSET_WORDS(MAZE_CELLS(maze));
+  cache->budget = budget;
+  return cache;
+}
+
+// Frees the cache and all the BFS results in it.
+void maze_cache_free(maze_cache_t *cache) {
+  cacheentry_t *entry = cache->newest;
+  while (entry != NULL) {
+    cacheentry_t *older = entry->older;
+    free(entry->pred);
+    free(entry->found);
+    free(entry);
+    entry = older;
+  }
+  free(cache->by_start);
+  free(cache);
+}
+
+// Unlinks `entry` from the recency list of `cache`.
+static void cache_unlink(maze_cache_t *cache, cacheentry_t *entry) {
+  if (entry->newer != NULL) {
+    entry->newer->older = entry->older;
+  } else {
+    cache->newest = entry->older;
+  }
+  if (entry->older != NULL) {
+    entry->older->newer = entry->newer;
+  } else {
+    cache->oldest = entry->newer;
+  }
+}
+
+// Links `entry` into the recency list of `cache` as the newest.
+static void cache_push_newest(maze_cache_t *cache, cacheentry_t *entry) {
+  entry->newer = NULL;
+  entry->older = cache->newest;
+  if (cache->newest != NULL) {
+    cache->newest->newer = entry;
+  } else {
+    cache->oldest = entry;
+  }
+  cache->newest = entry;
+}
+
+// Returns the cached BFS result for grid index `start`, refreshed as
+// the most recently used. On a miss floods `maze` from `start`, takes
+// over its predecessors and a copy of its FOUND bits as a new entry
+// and evicts the oldest entries beyond the budget.
+static cacheentry_t *cache_lookup(maze_t *maze, maze_cache_t *cache, int start, int *hit) {
+  cacheentry_t *entry = cache->by_start[start];
+  *hit = entry != NULL;
+  if (entry != NULL) {
+    cache_unlink(cache, entry);
+    cache_push_newest(cache, entry);
+    return entry;
+  }
+
+  int start_row = maze->start_row, start_col = maze->start_col;
+  maze->start_row = start / maze->stride - 1;
+  maze->start_col = start % maze->stride - 1;
+  maze_bfs_iterate(maze);
+  maze->start_row = start_row;
+  maze->start_col = start_col;
+
+  entry = malloc(sizeof(cacheentry_t));
+  entry->start = start;
+  entry->pred = maze->pred;  // taken over; the next search allocates fresh predecessors
+  maze->pred = NULL;
+  long words = BITSET_WORDS(MAZE_CELLS(maze));
+  entry->found = malloc(sizeof(uint64_t) * words);
+  memcpy(entry->found, maze->found, sizeof(uint64_t) * words);
+  cache->by_start[start] = entry;
+  cache_push_newest(cache, entry);
+  cache->count++;
+
+  while (cache->count > 1 && cache->count * cache->entry_bytes > cache->budget) {
+    cacheentry_t *oldest = cache->oldest;
+    cache_unlink(cache, oldest);
+    cache->by_start[oldest->start] = NULL;
+    free(oldest->pred);
+    free(oldest->found);
+    free(oldest);
+    cache->count--;
+    cache->evictions++;
+  }
+  return entry;
+}
+
+// Prints the query counts, hit rate and mean latencies in `cache` to `out`.
+void maze_cache_print_stats(maze_cache_t *cache, FILE *out) {
+  long misses = cache->queries - cache->hits;
+  fprintf(out, "queries: %ld hits: %ld (%.1f%%) misses: %ld evictions: %ld cached starts: %ld\n",
+          cache->queries, cache->hits,
+          cache->queries > 0 ? 100.0 * cache->hits / cache->queries : 0.0,
+          misses, cache->evictions, cache->count);
+  fprintf(out, "mean latency ms: all %.3f hit %.3f miss %.3f\n",
+          cache->queries > 0 ? cache->total_ns / 1e6 / cache->queries : 0.0,
+          cache->hits > 0 ? cache->hit_ns / 1e6 / cache->hits : 0.0,
+          misses > 0 ? (cache->total_ns - cache->hit_ns) / 1e6 / misses : 0.0);
+  if (cache->rejected > 0) {
+    fprintf(out, "rejected by components: %ld\n", cache->rejected);
+  }
+}
+
+// Answers one query from (sr,sc) to (er,ec) on `out`: the path length,
+// whether the start was cached and the latency, then the compact path.
+static void serve_query(maze_t *maze, maze_cache_t *cache, FILE *out, int sr, int sc, int er, int ec) {
+  if (sr < 0 || sr >= maze->rows || sc < 0 || sc >= maze->cols || MAZE_TYPE(maze, sr, sc) == WALL ||
+      er < 0 || er >= maze->rows || ec < 0 || ec >= maze->cols || MAZE_TYPE(maze, er, ec) == WALL) {
+    fprintf(out, "ERROR: query tiles must be open tiles inside the maze\n");
+    return;
+  }
+  if (!maze_connected(maze, sr, sc, er, ec)) {
+    cache->rejected++;
+    fprintf(out, "no path (components)\n");
+    return;
+  }
+  long begin = server_now_ns();
+  int hit;
+  cacheentry_t *entry = cache_lookup(maze, cache, MAZE_INDEX(maze, sr, sc), &hit);
+
+  // Walk the cached predecessors with the maze's own path code
+  unsigned char *pred = maze->pred;
+  uint64_t *found = maze->found;
+  int *dist = maze->dist;
+  int start_row = maze->start_row, start_col = maze->start_col;
+  maze->pred = entry->pred;
+  maze->found = entry->found;
+  maze->dist = NULL;
+  maze->start_row = sr;
+  maze->start_col = sc;
+  tile_t path = {.path = NULL, .path_len = -1};
+  maze_tile_path(maze, er, ec, &path);
+  maze->pred = pred;
+  maze->found = found;
+  maze->dist = dist;
+  maze->start_row = start_row;
+  maze->start_col = start_col;
+
+  long elapsed = server_now_ns() - begin;
+  cache->queries++;
+  cache->total_ns += elapsed;
+  if (hit) {
+    cache->hits++;
+    cache->hit_ns += elapsed;
+  }
+
+  if (path.path == NULL) {
+    fprintf(out, "no path (%s, %.3f ms)\n", hit ? "hit" : "miss", elapsed / 1e6);
+  } else {
+    fprintf(out, "path length: %d (%s, %.3f ms)\n", path.path_len, hit ? "hit" : "miss", elapsed / 1e6);
+    for (int i = 0; i < path.path_len; i++) {
+      fputs(direction_compact_strs[path.path[i]], out);
+    }
+    fputc('\n', out);
+  }
+  free(path.path);
+}
+
+// Reads queries and commands from `in` until end of input or "quit",
+// answering each on `out`. Returns 1 if "quit" was read and 0 at the
+// end of input or once answers can no longer be written.
+int maze_serve(maze_t *maze, maze_cache_t *cache, FILE *in, FILE *out) {
+  char line[256];
+  while (fgets(line, sizeof(line), in) != NULL) {
+    int sr, sc, er, ec;
+    char word[16];
+    if (sscanf(line, "%d %d %d %d", &sr, &sc, &er, &ec) == 4) {
+      serve_query(maze, cache, out, sr, sc, er, ec);
+    } else if (sscanf(line, "%15s", word) != 1) {
+      continue;  // blank line
+    } else if (strcmp(word, "stats") == 0) {
+      maze_cache_print_stats(cache, out);
+    } else if (strcmp(word, "quit") == 0) {
+      fflush(out);
+      return 1;
+    } else {
+      fprintf(out, "ERROR: expected 'start_row start_col end_row end_col', 'stats' or 'quit'\n");
+    }
+    if (fflush(out) != 0 || ferror(out)) {
+      return 0;  // the reader of the answers is gone
+    }
+  }
+  return 0;
+}
+
+// Listens on a Unix socket at `path` and serves one client connection
+// at a time with maze_serve() until a client sends "quit". The cache is
+// shared by all connections; a client that goes away is dropped and
+// the next one accepted. A socket left at `path` by an earlier server
+// is replaced, but any other file there is an error. Returns 0 on
+// success and 1 if the socket could not be set up.
+int maze_serve_socket(maze_t *maze, maze_cache_t *cache, char *path) {
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    printf("ERROR: socket path %s is too long\n", path);
+    return 1;
+  }
+  strcpy(addr.sun_path, path);
+
+  // Remove a socket left by an earlier server but nothing else
+  struct stat st;
+  if (lstat(path, &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      printf("ERROR: %s exists and is not a socket\n", path);
+      return 1;
+    }
+    unlink(path);
+  }
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 || bind(listener, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(listener, 8) < 0) {
+    perror("ERROR: could not listen on socket");
+    if (listener >= 0) {
+      close(listener);
+    }
+    return 1;
+  }
+
+  // A client that disconnects before reading its answers makes writes
+  // fail rather than killing the server with SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+  int quit = 0;
+  while (!quit) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) {
+      perror("ERROR: accept failed");
+      break;
+    }
+    FILE *in = fdopen(fd, "r");
+    FILE *out = fdopen(dup(fd), "w");
+    quit = maze_serve(maze, cache, in, out);
+    fclose(in);
+    fclose(out);
+  }
+  close(listener);
+  unlink(path);
+  return 0;
+}